@@ -121,6 +121,75 @@ def plot_per_client_jitter(filename):
     except Exception as e:
         print(f"Error processing {filename}: {e}")
 
+def plot_log_summary(filename):
+    """Plot per-log percentiles and loss written by rtp-log-analyzer"""
+    try:
+        df = pd.read_csv(filename)
+        labels = [os.path.splitext(name)[0] for name in df['file']]
+
+        plt.figure(figsize=(12, 8))
+
+        # Plot jitter percentiles per log
+        plt.subplot(2, 1, 1)
+        plt.plot(range(len(df)), df['jitter_p50_ms'], 'b.-', label='p50')
+        plt.plot(range(len(df)), df['jitter_p99_ms'], 'r.-', label='p99')
+        plt.title(f'Jitter Percentiles - {os.path.basename(filename)}')
+        plt.ylabel('Jitter (ms)')
+        if len(labels) <= 50:  # Label logs only while they stay readable
+            plt.xticks(range(len(labels)), labels, rotation=90)
+        plt.grid(True)
+        plt.legend()
+
+        # Plot loss per log
+        plt.subplot(2, 1, 2)
+        plt.bar(range(len(df)), df['loss_pct'], color='g', label='Loss (%)')
+        plt.title('Packet Loss')
+        plt.xlabel('Log')
+        plt.ylabel('Loss (%)')
+        plt.grid(True)
+        plt.legend()
+
+        plt.tight_layout()
+
+        # Save plot
+        output_file = os.path.splitext(filename)[0] + '_plot.png'
+        plt.savefig(output_file)
+        print(f"Plot saved to {output_file}")
+
+        plt.close()
+    except Exception as e:
+        print(f"Error processing {filename}: {e}")
+
+def plot_log_histogram(filename):
+    """Plot global jitter/delay CDFs from rtp-log-analyzer histogram buckets"""
+    try:
+        df = pd.read_csv(filename)
+
+        plt.figure(figsize=(12, 8))
+
+        for i, metric in enumerate(['jitter', 'delay']):
+            plt.subplot(2, 1, i + 1)
+            for kind, group in df[df['metric'] == metric].groupby('kind'):
+                group = group.sort_values('value_ms')
+                cdf = group['count'].cumsum() / group['count'].sum()
+                plt.plot(group['value_ms'], cdf, label=f'{kind} {metric}')
+            plt.title(f'{metric.capitalize()} CDF')
+            plt.xlabel(f'{metric.capitalize()} (ms)')
+            plt.ylabel('Fraction of packets')
+            plt.grid(True)
+            plt.legend()
+
+        plt.tight_layout()
+
+        # Save plot
+        output_file = os.path.splitext(filename)[0] + '_plot.png'
+        plt.savefig(output_file)
+        print(f"Plot saved to {output_file}")
+
+        plt.close()
+    except Exception as e:
+        print(f"Error processing {filename}: {e}")
+
 def check_file_content(filename):
     """Check if file exists and has content"""
     try:
@@ -133,6 +202,16 @@ def check_file_content(filename):
         print(f"File {filename} doesn't exist or is inaccessible.")
         return False
 
+def plot_summary_file(filename):
+    """Dispatch an rtp-log-analyzer summary to the matching plot"""
+    name = os.path.basename(filename)
+    if name == "log_summary_server_stats.csv":
+        plot_server_jitter(filename)  # Same columns as server_stats.csv
+    elif name == "log_summary_histogram.csv":
+        plot_log_histogram(filename)
+    else:
+        plot_log_summary(filename)
+
 def plot_all_files():
     """Find and plot all jitter log files"""
     # Process client jitter logs
@@ -156,7 +235,14 @@ def plot_all_files():
             print(f"Processing jitter file: {filename}")
             plot_per_client_jitter(filename)  # Use the new function
     
-    if not (client_files or server_files or jitter_files):
+    # Process summaries written by rtp-log-analyzer from binary logs
+    summary_files = glob.glob("log_summary_*.csv")
+    for filename in summary_files:
+        if check_file_content(filename):
+            print(f"Processing summary file: {filename}")
+            plot_summary_file(filename)
+    
+    if not (client_files or server_files or jitter_files or summary_files):
         print("No jitter log files found. Run the RTP server and clients first.")
 
 if __name__ == "__main__":
@@ -166,7 +252,9 @@ if __name__ == "__main__":
         if not check_file_content(filename):
             sys.exit(1)
 
-        if filename.startswith("client_jitter_"):
+        if os.path.basename(filename).startswith("log_summary_"):
+            plot_summary_file(filename)
+        elif filename.startswith("client_jitter_"):
             plot_client_jitter(filename)
         elif filename == "server_stats.csv":
             plot_server_jitter(filename)
@@ -8,6 +8,9 @@
 #include <mutex>
 #include <map>
 #include <condition_variable>
+#include <sched.h>
+#include <csignal>
+#include <cstring>
 
 // Global variables for client management
 std::atomic<bool> running(true);
@@ -16,6 +19,11 @@ std::mutex clientsMutex;
 std::map<int, std::shared_ptr<RTPClient>> activeClients;
 std::condition_variable clientCv;
 
+// SIGINT/SIGTERM interrupt the console read; shutdown then stops every client and closes its log
+static void stopClients(int) {
+    running = false;
+}
+
 // Function to send a message to a specific client
 void sendMessageToClient(int clientNum, const std::string& message) {
     std::lock_guard<std::mutex> lock(clientsMutex);
@@ -29,12 +37,24 @@ void sendMessageToClient(int clientNum, const std::string& message) {
 }
 
 // Thread function to run a client
-void runClient(const std::string& serverIP, int port, int clientNum) {
+void runClient(const std::string& serverIP, int port, int clientNum, bool binaryLogs,
+               const LowLatencyConfig& lowLatency, SrtpProfile srtpProfile, const std::string& srtpKey) {
     std::string clientId = "client_" + std::to_string(clientNum);
     
     // Create the client
     std::shared_ptr<RTPClient> client = std::make_shared<RTPClient>(serverIP, port, clientId);
     client->enableFEC(true);
+    if (binaryLogs) {
+        client->enableBinaryLogs(true);
+    }
+    if (lowLatency.enabled) {
+        client->enableLowLatency(lowLatency);
+    }
+    if (!srtpKey.empty() && !client->enableSrtp(srtpProfile, srtpKey)) {
+        std::cerr << "[" << clientId << "] Not started: invalid SRTP key" << std::endl;
+        clientCv.notify_all();
+        return;
+    }
     
     {
         std::lock_guard<std::mutex> lock(clientsMutex);
@@ -45,6 +65,9 @@ void runClient(const std::string& serverIP, int port, int clientNum) {
     // Notify that the client is ready
     clientCv.notify_all();
     
+    // Receive replies and forwarded streams in the background
+    client->startReceiving();
+    
     // Keep client running until program terminates
     while (running) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -67,10 +90,17 @@ void displayHelp() {
     std::cout << "  list                   - List all active clients" << std::endl;
     std::cout << "  send <client> <msg>    - Send message to specific client" << std::endl;
     std::cout << "  broadcast <msg>        - Send message to all clients" << std::endl;
+    std::cout << "  subscribe <client> <stream>   - Subscribe client to a stream (SFU mode)" << std::endl;
+    std::cout << "  unsubscribe <client> <stream> - Unsubscribe client from a stream" << std::endl;
     std::cout << "  exit                   - Exit the program" << std::endl;
     std::cout << "-----------------------\n" << std::endl;
 }
 
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [clients] [server-ip] [binlog] [lowlatency[:cpu[,cpu...]]] [srtp[:cm]]"
+              << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     std::string serverIP = "127.0.0.1"; 
     int basePort = 8080;
@@ -85,17 +115,79 @@ int main(int argc, char* argv[]) {
         serverIP = argv[2];
     }
     
+    // Optional modes: "binlog" (binary logs), "lowlatency[:cpu[,cpu...]]" (pinned
+    // spin-polling; one CPU per client, or a first CPU the clients count up from),
+    // "srtp[:cm]" (encryption, master key and salt in hex from RTP_SRTP_KEY)
+    bool binaryLogs = false;
+    LowLatencyConfig lowLatency;
+    std::vector<int> workerCpus;
+    SrtpProfile srtpProfile = SrtpProfile::AeadAes128Gcm;
+    std::string srtpKey;
+    for (int i = 3; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "binlog") {
+            binaryLogs = true;
+        } else if (parseSrtpOption(option, srtpProfile)) {
+            const char* key = getenv("RTP_SRTP_KEY");
+            if (key == NULL || *key == '\0') {
+                std::cerr << "SRTP needs the session's master key and salt in hex in RTP_SRTP_KEY" << std::endl;
+                return 1;
+            }
+            srtpKey = key;
+        } else if (option.compare(0, 10, "lowlatency") == 0) {
+            if (!parseLowLatencyOption(option, lowLatency, workerCpus)) {
+                return 1;
+            }
+        } else {
+            // A mistyped mode must not silently start without it (e.g. plaintext for "srtp:CM")
+            std::cerr << "Unknown option " << option << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (workerCpus.size() > 1 && workerCpus.size() < static_cast<size_t>(numClients)) {
+        std::cerr << "lowlatency lists " << workerCpus.size() << " CPUs for " << numClients
+                  << " clients; give one each, or only the first" << std::endl;
+        return 1;
+    }
+    if (workerCpus.size() == 1 && workerCpus[0] + numClients > CPU_SETSIZE) {
+        std::cerr << "Not enough CPUs from " << workerCpus[0] << " for " << numClients << " clients" << std::endl;
+        return 1;
+    }
+    
     std::cout << "Starting " << numClients << " clients connecting to " << serverIP << std::endl;
     
     std::vector<std::thread> clientThreads;
     
+    // Client threads block the stop signals so they reach the console thread; no
+    // SA_RESTART, so its blocked read returns
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopClients;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, NULL);
+    
     // Create and start all clients
     for (int i = 1; i <= numClients; i++) {
-        clientThreads.push_back(std::thread(runClient, serverIP, basePort, i));
+        // Spinning threads must not share a CPU
+        if (workerCpus.size() == 1) {
+            lowLatency.workerCpu = workerCpus[0] + i - 1;
+        } else if (!workerCpus.empty()) {
+            lowLatency.workerCpu = workerCpus[i - 1];
+        }
+        clientThreads.push_back(std::thread(runClient, serverIP, basePort, i, binaryLogs, lowLatency,
+                                           srtpProfile, srtpKey));
         
         // Brief pause to ensure client startup is staggered
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
+    pthread_sigmask(SIG_UNBLOCK, &stopSignals, NULL);
     
     // Wait for all clients to initialize
     {
@@ -115,6 +207,10 @@ int main(int argc, char* argv[]) {
         std::cout << "> ";
         std::getline(std::cin, command);
         
+        if (!running) {
+            std::cout << "Shutting down all clients..." << std::endl;
+            break;
+        }
         if (command == "exit") {
             running = false;
             std::cout << "Shutting down all clients..." << std::endl;
@@ -159,6 +255,20 @@ int main(int argc, char* argv[]) {
                 pair.second->sendPacket(message);
             }
         }
+        else if (command.substr(0, 10) == "subscribe " || command.substr(0, 12) == "unsubscribe ") {
+            // Parse "[un]subscribe <client_num> <stream>", e.g. "subscribe 2 client_1"
+            bool subscribe = command[0] == 's';
+            std::istringstream iss(command.substr(subscribe ? 10 : 12));
+            int clientNum;
+            std::string stream;
+            
+            if (iss >> clientNum >> stream) {
+                sendMessageToClient(clientNum, (subscribe ? "SUBSCRIBE " : "UNSUBSCRIBE ") + stream);
+            } else {
+                std::cout << "Invalid format. Use: " << (subscribe ? "subscribe" : "unsubscribe")
+                          << " <client_num> <stream>" << std::endl;
+            }
+        }
         else {
             std::cout << "Unknown command. Type 'help' for available commands." << std::endl;
         }
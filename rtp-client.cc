@@ -2,16 +2,15 @@
 #include <cstring>
 #include <unistd.h>
 #include <iostream>
-#include <queue>
 #include <chrono>
-#include <mutex>
+#include <cstdio>
+#include <cerrno>
+#include <algorithm>
 #include <sys/time.h>
 
-std::queue<std::string> jitterBuffer;  // Buffer to handle delayed packets
-std::mutex jitterBufferMutex;
-
 RTPClient::RTPClient(const std::string& serverIP, int port, const std::string& clientId)
-    : fecEnabled(false), clientId(clientId), running(true) {
+    : fecEnabled(false), clientId(clientId), running(true), sendSequence(0), srtpEnabled(false),
+      srtpSsrc(0) {
     sockfd = socket(AF_INET, SOCK_DGRAM, 0);
     if (sockfd < 0) {
         perror("Socket creation failed");
@@ -27,35 +26,52 @@ RTPClient::RTPClient(const std::string& serverIP, int port, const std::string& c
         exit(EXIT_FAILURE);
     }
     
+    // Wake up regularly while idle so the binary log is flushed
+    struct timeval timeout = {0, 250000};
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+        perror("Failed to set receive timeout");
+    }
+    
+    enableReceiveTimestamps(sockfd);
+    
     // Create jitter log file
     std::string logFilename = "client_jitter_" + clientId + ".csv";
     jitterLog.open(logFilename);
     
     if (jitterLog.is_open()) {
-        jitterLog << "timestamp,packet_id,buffer_size,processing_time_ms\n";
+        jitterLog << "timestamp,packet_id,source,sequence,buffer_size,processing_time_ms,jitter_ms,delay_ms\n";
     } else {
         std::cerr << "Failed to open jitter log file" << std::endl;
     }
 }
 
 RTPClient::~RTPClient() {
+    if (processingThread.joinable()) {
+        stop();
+    }
     if (jitterLog.is_open()) {
         jitterLog.close();
     }
+    binaryLog.close();
     close(sockfd);
 }
 
 void RTPClient::sendPacket(const std::string& message) {
-    static int packetId = 0;
-    packetId++;
-    
-    // Get current timestamp
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    long long sendTimestamp = tv.tv_sec * 1000LL + tv.tv_usec / 1000; // milliseconds
+    int packetId = ++sendSequence;
     
-    // Add packet ID to message for tracking
-    std::string packetMessage = "[" + clientId + "|" + std::to_string(packetId) + "] " + message;
+    // Add packet ID and send timestamp to message for tracking
+    RTPHeader header;
+    header.source = clientId;
+    header.sequence = packetId;
+    header.sendTimeNs = wallClockNs();
+    if (srtpEnabled) {
+        header.ssrc = srtpSsrc;
+    }
+    std::string packetMessage = buildPacket(header, message);
+    if (srtpEnabled && !srtpOut.protect(packetMessage, packetMessage.size() - message.size(), header)) {
+        std::cerr << "[" << clientId << "] SRTP protect failed, packet not sent" << std::endl;
+        return;
+    }
     
     sendto(sockfd, packetMessage.c_str(), packetMessage.size(), 0,
            (struct sockaddr*)&serverAddr, sizeof(serverAddr));
@@ -65,21 +81,52 @@ void RTPClient::sendPacket(const std::string& message) {
 }
 
 void RTPClient::packetProcessingThread() {
-    char buffer[1024];
+    if (lowLatency.enabled) {
+        // Pin first so the buffers below are allocated on this CPU's node
+        placeCurrentThread(lowLatency.workerCpu, "[" + clientId + "] Processing thread");
+        enableSpinPolling(sockfd, lowLatency.busyPollUsec);
+    }
+    
+    char buffer[kMaxPacketSize];
     int packetId = 0;
     
     while (running) {
-        socklen_t len = sizeof(serverAddr);
-        int bytesReceived = recvfrom(sockfd, buffer, sizeof(buffer), 0,
-                                    (struct sockaddr*)&serverAddr, &len);
+        struct sockaddr_in fromAddr;
+        socklen_t len = sizeof(fromAddr);
+        ReceiveTime recvTime;
+        int bytesReceived = recvWithTimestamp(sockfd, buffer, sizeof(buffer) - 1,
+                                              &fromAddr, &len, recvTime);
+        if (bytesReceived < 0 && (wouldBlock() || errno == EINTR)) {
+            // Idle timeout, or in low-latency mode nothing queued yet: keep spinning
+            binaryLog.flushIfDue();
+            cpuRelax();
+            continue;
+        }
                                     
         if (bytesReceived > 0 && running) {
+            long long receiveTimestamp = recvTime.ns / 1000000; // milliseconds
+            
+            RTPHeader header;
+            size_t payloadOffset = 0;
+            bool parsed = parsePacket(buffer, bytesReceived, header, payloadOffset);
+            
+            // Drop anything that is not authentic, fresh SRTP
+            if (srtpEnabled) {
+                size_t length = bytesReceived;
+                if (!parsed || !srtpIn.unprotect(buffer, length, payloadOffset, header, fromAddr)) {
+                    continue;
+                }
+                bytesReceived = static_cast<int>(length);
+            }
             buffer[bytesReceived] = '\0';
             
-            // Get receive timestamp
-            struct timeval tv;
-            gettimeofday(&tv, NULL);
-            long long receiveTimestamp = tv.tv_sec * 1000LL + tv.tv_usec / 1000;
+            // Measure jitter and one-way delay against the sender's send timestamp, per
+            // sender so the server's replies and forwarded streams are not mixed
+            JitterEstimator& estimator = jitter[header.source];
+            double delayMs = 0.0;
+            if (parsed && header.sendTimeNs > 0) {
+                delayMs = estimator.update(header.sendTimeNs, recvTime) / 1e6;
+            }
             
             // Add to jitter buffer
             jitterBufferMutex.lock();
@@ -87,16 +134,34 @@ void RTPClient::packetProcessingThread() {
             int bufferSize = jitterBuffer.size();
             jitterBufferMutex.unlock();
             
-            // Simulate processing time (proportional to buffer size)
-            int processingTime = 10 + (bufferSize * 5); // Base 10ms + 5ms per buffered packet
-            std::this_thread::sleep_for(std::chrono::milliseconds(processingTime));
+            // Simulate processing time (proportional to buffer size), except in low-latency mode
+            int processingTime = lowLatency.enabled ? 0 : 10 + (bufferSize * 5); // Base 10ms + 5ms per buffered packet
+            if (processingTime > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(processingTime));
+            }
             
             // Log jitter data
-            if (jitterLog.is_open()) {
+            if (binaryLog.is_open()) {
+                ClientJitterRecord record;
+                record.timestamp = receiveTimestamp;
+                record.packetId = ++packetId;
+                memset(record.source, 0, sizeof(record.source));
+                memcpy(record.source, header.source.data(), std::min(header.source.size(), sizeof(record.source)));
+                record.sequence = header.sequence;
+                record.bufferSize = bufferSize;
+                record.processingTimeMs = processingTime;
+                record.jitterMs = static_cast<float>(estimator.jitterMs());
+                record.delayMs = static_cast<float>(delayMs);
+                binaryLog.append(&record);
+            } else if (jitterLog.is_open()) {
                 jitterLog << receiveTimestamp << ","
                          << ++packetId << ","
+                         << header.source << ","
+                         << header.sequence << ","
                          << bufferSize << ","
-                         << processingTime << "\n";
+                         << processingTime << ","
+                         << estimator.jitterMs() << ","
+                         << delayMs << "\n";
                 jitterLog.flush();
             }
             
@@ -111,10 +176,12 @@ void RTPClient::packetProcessingThread() {
     }
 }
 
+void RTPClient::startReceiving() {
+    processingThread = std::thread(&RTPClient::packetProcessingThread, this);
+}
+
 void RTPClient::start() {
-    // Start the packet processing thread
-    std::thread processingThread(&RTPClient::packetProcessingThread, this);
-    processingThread.detach(); // Detach so it runs independently
+    startReceiving();
     
     std::string message;
     while (running) {
@@ -132,8 +199,47 @@ void RTPClient::start() {
 
 void RTPClient::stop() {
     running = false;
-    // Send a dummy packet to unblock the recvfrom in the processing thread
-    sendto(sockfd, "EXIT", 4, 0, (struct sockaddr*)&serverAddr, sizeof(serverAddr));
+    // Wakes a processing thread blocked in recvfrom, then waits for it
+    shutdown(sockfd, SHUT_RD);
+    if (processingThread.joinable()) {
+        processingThread.join();
+    }
+}
+
+void RTPClient::enableBinaryLogs(bool enable) {
+    std::string logFilename = "client_jitter_" + clientId;
+    if (enable) {
+        // Replace the CSV opened by the constructor
+        if (jitterLog.is_open()) {
+            jitterLog.close();
+            std::remove((logFilename + ".csv").c_str());
+        }
+        if (!binaryLog.open(logFilename + ".rtplog", kClientJitterSchema)) {
+            std::cerr << "Failed to open jitter log file" << std::endl;
+        }
+    } else {
+        binaryLog.close();
+        if (!jitterLog.is_open()) {
+            jitterLog.open(logFilename + ".csv");
+            jitterLog << "timestamp,packet_id,source,sequence,buffer_size,processing_time_ms,jitter_ms,delay_ms\n";
+        }
+    }
+    std::cout << "[" << clientId << "] Binary logs: " << (enable ? "Yes" : "No") << std::endl;
+}
+
+void RTPClient::enableLowLatency(const LowLatencyConfig& config) {
+    lowLatency = config;
+    std::cout << "[" << clientId << "] Low-latency mode: " << (config.enabled ? "Yes" : "No") << std::endl;
+}
+
+bool RTPClient::enableSrtp(SrtpProfile profile, const std::string& keyHex) {
+    if (!srtpIn.init(profile, keyHex) || !srtpOut.init(profile, keyHex)) {
+        return false;
+    }
+    srtpEnabled = true;
+    srtpSsrc = newSrtpSsrc();
+    std::cout << "[" << clientId << "] SRTP: " << srtpProfileName(profile) << std::endl;
+    return true;
 }
 
 void RTPClient::enableFEC(bool enable) {
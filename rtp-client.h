@@ -8,15 +8,27 @@
 #include <fstream>
 #include <thread>
 #include <atomic>
+#include <queue>
+#include <map>
+#include <mutex>
+#include "rtp-timestamp.h"
+#include "rtp-packet.h"
+#include "rtp-log.h"
+#include "rtp-lowlatency.h"
+#include "rtp-srtp.h"
 
 class RTPClient {
 public:
     RTPClient(const std::string& serverIP, int port, const std::string& clientId = "default");
     ~RTPClient();
 
-    void start(); // Starts the client
+    void start(); // Starts the client with a console for messages
+    void startReceiving(); // Starts only the packet processing thread; stop() joins it
     void sendPacket(const std::string& message); // Sends an RTP packet
     void enableFEC(bool enable); // Enables FEC on the client-side
+    void enableBinaryLogs(bool enable); // Writes a .rtplog columnar log instead of CSV
+    void enableLowLatency(const LowLatencyConfig& config); // Pinned, spin-polling processing thread (call before start())
+    bool enableSrtp(SrtpProfile profile, const std::string& keyHex); // Encrypts and authenticates all traffic (call before start())
     void stop(); // Stops the client
 
 private:
@@ -25,7 +37,18 @@ private:
     bool fecEnabled;
     std::string clientId; // Client identifier
     std::ofstream jitterLog; // File to log jitter data
+    BinaryLogWriter binaryLog; // Used instead of jitterLog when binary logs are enabled
     std::atomic<bool> running;
+    std::thread processingThread;
+    std::queue<std::string> jitterBuffer; // Buffer to handle delayed packets
+    std::mutex jitterBufferMutex;
+    int sendSequence; // Sequence number of the last packet sent by this client
+    std::map<std::string, JitterEstimator> jitter; // Interarrival jitter per sender: "server" or a forwarded stream
+    LowLatencyConfig lowLatency;
+    bool srtpEnabled;
+    uint64_t srtpSsrc; // Random SSRC of this client's outgoing stream
+    SrtpContext srtpIn;  // Packets from the server, with their replay windows
+    SrtpContext srtpOut;
 
     void receivePacket();
     void applyFEC(std::string& message); // FEC error correction method
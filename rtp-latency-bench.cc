@@ -0,0 +1,162 @@
+#include "rtp-server.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+// Measures the real server path: a request goes through RTPServer's receive
+// loop and packet pipeline (FEC, simulated congestion and logging off) and the
+// "Acknowledged" reply comes back. Latency is the time from the send call to
+// the kernel receive timestamp of the reply, so the benchmark's own wakeup is
+// not counted. Runs once with the default blocking loop and once in low-latency
+// mode (pinned, spin-polling).
+//
+// Usage: rtp-latency-bench [packets] [gap-us] [receive-cpu]
+
+struct LatencyResult {
+    std::vector<int64_t> samples; // Nanoseconds
+    size_t lost;
+    bool kernelTimestamps;
+
+    LatencyResult() : lost(0), kernelTimestamps(true) {}
+
+    int64_t percentile(double p) const {
+        if (samples.empty()) {
+            return 0;
+        }
+        size_t index = std::min(samples.size() - 1, static_cast<size_t>(p / 100.0 * samples.size()));
+        return samples[index];
+    }
+};
+
+static int freePort() {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        getsockname(fd, (struct sockaddr*)&addr, &addrLen) < 0) {
+        perror("Bind failed");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static LatencyResult measure(size_t count, int gapUs, const LowLatencyConfig& config) {
+    int port = freePort();
+    LatencyResult result;
+    result.samples.reserve(count);
+
+    // The server reports settings and start-up on stdout, keep it out of the results
+    std::ofstream devNull("/dev/null");
+    std::streambuf* original = std::cout.rdbuf(devNull.rdbuf());
+    RTPServer server(port);
+    server.enableLogging(false);
+    if (config.enabled) {
+        server.enableLowLatency(config);
+    }
+    std::thread serverThread(&RTPServer::start, &server);
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct timeval timeout = {1, 0};
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    enableReceiveTimestamps(sockfd);
+    struct sockaddr_in serverAddr;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    serverAddr.sin_port = htons(port);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // One request in flight at a time; the gap makes a blocking server really sleep
+    char buffer[kMaxPacketSize];
+    std::string payload(200, 'l');
+    for (size_t i = 0; i < count; i++) {
+        RTPHeader header;
+        header.source = "bench";
+        header.sequence = static_cast<int>(i);
+        header.sendTimeNs = wallClockNs();
+        std::string packet = buildPacket(header, payload);
+        int64_t sentNs = wallClockNs();
+        sendto(sockfd, packet.data(), packet.size(), 0, (struct sockaddr*)&serverAddr, sizeof(serverAddr));
+
+        struct sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        ReceiveTime recvTime;
+        if (recvWithTimestamp(sockfd, buffer, sizeof(buffer), &from, &fromLen, recvTime) < 0) {
+            result.lost++;
+        } else {
+            if (recvTime.source == TimestampSource::Monotonic) {
+                result.kernelTimestamps = false;
+            }
+            result.samples.push_back(recvTime.ns - sentNs);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(gapUs));
+    }
+
+    server.stop();
+    serverThread.join();
+    close(sockfd);
+    std::cout.rdbuf(original);
+
+    std::sort(result.samples.begin(), result.samples.end());
+    return result;
+}
+
+static void report(const std::string& name, const LatencyResult& result) {
+    if (result.samples.empty()) {
+        std::cout << "  " << name << ": no replies" << std::endl;
+        return;
+    }
+    std::cout << "  " << name << ": p50 " << result.percentile(50) / 1000.0 << "us, p99 "
+              << result.percentile(99) / 1000.0 << "us, p99.9 " << result.percentile(99.9) / 1000.0
+              << "us, max " << result.samples.back() / 1000.0 << "us";
+    if (result.lost > 0) {
+        std::cout << ", " << result.lost << " lost";
+    }
+    std::cout << std::endl;
+    if (!result.kernelTimestamps) {
+        std::cout << "    (no kernel receive timestamps, numbers include the benchmark's own wakeup)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 20000;
+    int gapUs = argc > 2 ? std::stoi(argv[2]) : 100;
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    int receiveCpu = argc > 3 ? std::stoi(argv[3]) : static_cast<int>(cpus) - 1;
+
+    // The server writes its stats log into the current directory
+    char scratch[] = "/tmp/rtp-latency-bench-XXXXXX";
+    if (mkdtemp(scratch) == NULL || chdir(scratch) != 0) {
+        perror("Failed to create scratch directory");
+        return 1;
+    }
+
+    std::cout << "Request-to-reply latency through RTPServer: " << count << " packets, "
+              << gapUs << "us apart" << std::endl;
+    if (cpus < 2) {
+        std::cout << "Warning: only one CPU, the spinning server competes with the benchmark" << std::endl;
+    }
+
+    LowLatencyConfig blocking;
+    report("blocking receive loop", measure(count, gapUs, blocking));
+
+    LowLatencyConfig lowLatency;
+    lowLatency.enabled = true;
+    lowLatency.receiveCpu = receiveCpu;
+    report("low-latency mode (CPU " + std::to_string(receiveCpu) + ")", measure(count, gapUs, lowLatency));
+    return 0;
+}
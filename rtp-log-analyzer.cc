@@ -0,0 +1,353 @@
+#include "rtp-log.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <glob.h>
+
+// Streams .rtplog files written with enableBinaryLogs(true) and writes small
+// summary CSVs for plot.py:
+//   log_summary_clients.csv       one row per log file (loss, jitter and delay percentiles)
+//   log_summary_global.csv        the same statistics merged per log kind
+//   log_summary_histogram.csv     non-empty histogram buckets per kind and metric
+//   log_summary_server_stats.csv  server_stats.rtplog downsampled to at most kMaxStatsRows
+
+static const size_t kMaxStatsRows = 2000;
+
+// Log-linear histogram over microseconds: exact below 32us, then 32 buckets per
+// power of two (~3% relative error). Fixed size, so it merges across threads.
+struct Histogram {
+    static const int kSubBits = 5;
+    static const int kSubBuckets = 1 << kSubBits;
+    static const int kBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    double sum;
+    double maxValue;
+
+    Histogram() : counts(kBuckets, 0), total(0), sum(0.0), maxValue(0.0) {}
+
+    static int bucketFor(uint64_t us) {
+        if (us < static_cast<uint64_t>(kSubBuckets)) {
+            return static_cast<int>(us);
+        }
+        int msb = 63 - __builtin_clzll(us);
+        int shift = msb - kSubBits;
+        return (shift + 1) * kSubBuckets + static_cast<int>((us >> shift) - kSubBuckets);
+    }
+
+    // Midpoint of the bucket, in milliseconds
+    static double bucketValueMs(int index) {
+        if (index < kSubBuckets) {
+            return index / 1000.0;
+        }
+        int shift = index / kSubBuckets - 1;
+        double lower = static_cast<double>(static_cast<uint64_t>(index % kSubBuckets + kSubBuckets) << shift);
+        return (lower + std::ldexp(0.5, shift)) / 1000.0;
+    }
+
+    void add(double ms) {
+        double clamped = ms > 0.0 ? ms : 0.0; // Skewed clocks can give negative delay
+        counts[bucketFor(static_cast<uint64_t>(clamped * 1000.0))]++;
+        total++;
+        sum += clamped;
+        maxValue = std::max(maxValue, clamped);
+    }
+
+    void merge(const Histogram& other) {
+        for (int i = 0; i < kBuckets; i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    double percentile(double p) const {
+        if (total == 0) {
+            return 0.0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * total));
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; i++) {
+            seen += counts[i];
+            if (seen >= rank && counts[i] > 0) {
+                return std::min(bucketValueMs(i), maxValue);
+            }
+        }
+        return maxValue;
+    }
+
+    double mean() const { return total > 0 ? sum / total : 0.0; }
+};
+
+struct LogSummary {
+    std::string file;
+    std::string kind; // "server" for jitter_*, "client" for client_jitter_*
+    bool valid;       // Set once at least one jitter log has been merged in
+    uint64_t records;
+    uint64_t lost;
+    Histogram jitter;
+    Histogram delay;
+
+    LogSummary() : valid(false), records(0), lost(0) {}
+};
+
+struct StatsRow {
+    double timestamp;
+    double totalClients;
+    double totalPackets;
+    double avgJitterMs;
+};
+
+static std::string baseName(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// Sequence numbers seen from one sender, for the loss estimate
+struct SequenceRange {
+    double minSequence;
+    double maxSequence;
+    uint64_t records;
+
+    SequenceRange() : minSequence(0.0), maxSequence(0.0), records(0) {}
+};
+
+static void summarizeJitterLog(BinaryLogReader& reader, LogSummary& summary) {
+    int sequenceColumn = reader.findColumn("sequence");
+    if (sequenceColumn < 0) {
+        sequenceColumn = reader.findColumn("packet_id");
+    }
+    int sourceColumn = reader.findColumn("source"); // Client logs mix replies and forwarded streams
+    int jitterColumn = reader.findColumn("jitter_ms");
+    int delayColumn = reader.findColumn("delay_ms");
+
+    std::map<std::string, SequenceRange> ranges;
+    while (reader.nextBlock()) {
+        for (uint32_t row = 0; row < reader.blockSize(); row++) {
+            if (sequenceColumn >= 0) {
+                double sequence = reader.value(sequenceColumn, row);
+                SequenceRange& range = ranges[sourceColumn >= 0 ? reader.text(sourceColumn, row) : std::string()];
+                if (range.records == 0 || sequence < range.minSequence) {
+                    range.minSequence = sequence;
+                }
+                if (range.records == 0 || sequence > range.maxSequence) {
+                    range.maxSequence = sequence;
+                }
+                range.records++;
+            }
+            if (jitterColumn >= 0) {
+                summary.jitter.add(reader.value(jitterColumn, row));
+            }
+            if (delayColumn >= 0) {
+                summary.delay.add(reader.value(delayColumn, row));
+            }
+            summary.records++;
+        }
+    }
+
+    for (const auto& entry : ranges) {
+        const SequenceRange& range = entry.second;
+        double expected = range.maxSequence - range.minSequence + 1;
+        summary.lost += expected > range.records ? static_cast<uint64_t>(expected - range.records) : 0;
+    }
+}
+
+// Averages consecutive rows so the series stays near kMaxStatsRows; the stride
+// is estimated from the file size so the log never has to be held in memory
+static void summarizeServerStats(BinaryLogReader& reader, const std::string& filename,
+                                 std::vector<StatsRow>& rows) {
+    int timestampColumn = reader.findColumn("timestamp");
+    int clientsColumn = reader.findColumn("total_clients");
+    int packetsColumn = reader.findColumn("total_packets");
+    int jitterColumn = reader.findColumn("avg_jitter_ms");
+    if (timestampColumn < 0 || clientsColumn < 0 || packetsColumn < 0 || jitterColumn < 0) {
+        std::cerr << "Skipping " << filename << ": not a server stats log" << std::endl;
+        return;
+    }
+
+    size_t estimatedRows = reader.fileSize() / std::max<size_t>(reader.rowSize(), 1);
+    size_t stride = std::max<size_t>(1, (estimatedRows + kMaxStatsRows - 1) / kMaxStatsRows);
+
+    uint64_t samples = 0;
+    size_t inGroup = 0;
+    double jitterSum = 0.0;
+    StatsRow merged;
+    while (reader.nextBlock()) {
+        for (uint32_t row = 0; row < reader.blockSize(); row++) {
+            // Timestamp and counters are cumulative, so the group keeps its last values
+            merged.timestamp = reader.value(timestampColumn, row);
+            merged.totalClients = reader.value(clientsColumn, row);
+            merged.totalPackets = reader.value(packetsColumn, row);
+            jitterSum += reader.value(jitterColumn, row);
+            samples++;
+            if (++inGroup == stride) {
+                merged.avgJitterMs = jitterSum / inGroup;
+                rows.push_back(merged);
+                inGroup = 0;
+                jitterSum = 0.0;
+            }
+        }
+    }
+    if (inGroup > 0) {
+        merged.avgJitterMs = jitterSum / inGroup;
+        rows.push_back(merged);
+    }
+    std::cout << "Processed " << filename << ": " << samples << " samples" << std::endl;
+}
+
+static void writeSummaryRow(std::ostream& out, const std::string& name, const std::string& kind,
+                            uint64_t records, uint64_t lost,
+                            const Histogram& jitter, const Histogram& delay) {
+    uint64_t expected = records + lost;
+    out << name << "," << kind << "," << records << "," << lost << ","
+        << (expected > 0 ? 100.0 * lost / expected : 0.0) << ","
+        << jitter.mean() << "," << jitter.percentile(50) << "," << jitter.percentile(90) << ","
+        << jitter.percentile(99) << "," << jitter.maxValue << ","
+        << delay.mean() << "," << delay.percentile(50) << "," << delay.percentile(90) << ","
+        << delay.percentile(99) << "," << delay.maxValue << "\n";
+}
+
+static const char* kSummaryHeader =
+    "file,kind,records,lost,loss_pct,"
+    "jitter_mean_ms,jitter_p50_ms,jitter_p90_ms,jitter_p99_ms,jitter_max_ms,"
+    "delay_mean_ms,delay_p50_ms,delay_p90_ms,delay_p99_ms,delay_max_ms\n";
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        files.push_back(argv[i]);
+    }
+
+    // Default to every binary log in the current directory
+    if (files.empty()) {
+        glob_t matches;
+        if (glob("*.rtplog", 0, NULL, &matches) == 0) {
+            for (size_t i = 0; i < matches.gl_pathc; i++) {
+                files.push_back(matches.gl_pathv[i]);
+            }
+        }
+        globfree(&matches);
+    }
+    if (files.empty()) {
+        std::cout << "No .rtplog files found. Run the server/clients with binary logs enabled." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> kinds = {"server", "client"};
+    std::vector<std::string> rows(files.size()); // Formatted per-file summary rows
+    std::vector<LogSummary> global(kinds.size());
+    std::vector<StatsRow> statsRows;
+    std::mutex resultsMutex;
+    std::atomic<size_t> nextFile(0);
+
+    // One file at a time per worker; each log is a single sequential pass over its
+    // mmap. Workers keep their own per-kind totals and merge them once at the end.
+    auto worker = [&]() {
+        std::vector<LogSummary> local(kinds.size());
+        size_t index;
+        while ((index = nextFile++) < files.size()) {
+            const std::string& filename = files[index];
+            LogSummary summary;
+            summary.file = baseName(filename);
+            summary.kind = summary.file.compare(0, 14, "client_jitter_") == 0 ? "client" : "server";
+
+            BinaryLogReader reader;
+            if (!reader.open(filename)) {
+                std::cerr << "Skipping " << filename << ": not a binary log" << std::endl;
+                continue;
+            }
+            if (reader.findColumn("total_clients") >= 0) {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                summarizeServerStats(reader, filename, statsRows);
+                continue;
+            }
+            summarizeJitterLog(reader, summary);
+
+            std::ostringstream row;
+            writeSummaryRow(row, summary.file, summary.kind, summary.records, summary.lost,
+                            summary.jitter, summary.delay);
+            rows[index] = row.str();
+
+            LogSummary& merged = local[summary.kind == "client" ? 1 : 0];
+            merged.valid = true;
+            merged.records += summary.records;
+            merged.lost += summary.lost;
+            merged.jitter.merge(summary.jitter);
+            merged.delay.merge(summary.delay);
+        }
+
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        for (size_t k = 0; k < kinds.size(); k++) {
+            if (local[k].valid) {
+                global[k].valid = true;
+                global[k].records += local[k].records;
+                global[k].lost += local[k].lost;
+                global[k].jitter.merge(local[k].jitter);
+                global[k].delay.merge(local[k].delay);
+            }
+        }
+    };
+
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned>(threadCount, files.size());
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < threadCount; i++) {
+        threads.push_back(std::thread(worker));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::ofstream clientsOut("log_summary_clients.csv");
+    clientsOut << kSummaryHeader;
+    for (const std::string& row : rows) {
+        clientsOut << row;
+    }
+
+    std::ofstream globalOut("log_summary_global.csv");
+    globalOut << kSummaryHeader;
+    std::ofstream histogramOut("log_summary_histogram.csv");
+    histogramOut << "kind,metric,value_ms,count\n";
+    for (size_t k = 0; k < kinds.size(); k++) {
+        if (!global[k].valid) {
+            continue;
+        }
+        writeSummaryRow(globalOut, "all", kinds[k], global[k].records, global[k].lost,
+                        global[k].jitter, global[k].delay);
+        const Histogram* metrics[2] = {&global[k].jitter, &global[k].delay};
+        const char* names[2] = {"jitter", "delay"};
+        for (int m = 0; m < 2; m++) {
+            for (int i = 0; i < Histogram::kBuckets; i++) {
+                if (metrics[m]->counts[i] > 0) {
+                    histogramOut << kinds[k] << "," << names[m] << ","
+                                 << Histogram::bucketValueMs(i) << "," << metrics[m]->counts[i] << "\n";
+                }
+            }
+        }
+        std::cout << kinds[k] << " logs: " << global[k].records << " records, "
+                  << global[k].lost << " lost, jitter p99 " << global[k].jitter.percentile(99) << "ms" << std::endl;
+    }
+
+    if (!statsRows.empty()) {
+        std::ofstream statsOut("log_summary_server_stats.csv");
+        statsOut << "timestamp,total_clients,total_packets,avg_jitter_ms\n";
+        statsOut.precision(15);
+        for (const StatsRow& row : statsRows) {
+            statsOut << row.timestamp << "," << row.totalClients << ","
+                     << row.totalPackets << "," << row.avgJitterMs << "\n";
+        }
+    }
+
+    std::cout << "Summaries written to log_summary_*.csv" << std::endl;
+    return 0;
+}
@@ -0,0 +1,270 @@
+#include "rtp-log.h"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <chrono>
+
+static const char kLogMagic[8] = {'R', 'T', 'P', 'L', 'O', 'G', '1', '\0'};
+
+static int64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#define LOG_COLUMN(record, field, name, type) {name, LogColumnType::type, offsetof(record, field)}
+
+const std::vector<LogColumn> kServerJitterSchema = {
+    LOG_COLUMN(ServerJitterRecord, timestamp, "timestamp", Int64),
+    LOG_COLUMN(ServerJitterRecord, packetId, "packet_id", Int32),
+    LOG_COLUMN(ServerJitterRecord, sequence, "sequence", Int32),
+    LOG_COLUMN(ServerJitterRecord, jitterMs, "jitter_ms", Float32),
+    LOG_COLUMN(ServerJitterRecord, delayMs, "delay_ms", Float32)
+};
+
+const std::vector<LogColumn> kClientJitterSchema = {
+    LOG_COLUMN(ClientJitterRecord, timestamp, "timestamp", Int64),
+    LOG_COLUMN(ClientJitterRecord, packetId, "packet_id", Int32),
+    LOG_COLUMN(ClientJitterRecord, source, "source", Text32),
+    LOG_COLUMN(ClientJitterRecord, sequence, "sequence", Int32),
+    LOG_COLUMN(ClientJitterRecord, bufferSize, "buffer_size", Int32),
+    LOG_COLUMN(ClientJitterRecord, processingTimeMs, "processing_time_ms", Float32),
+    LOG_COLUMN(ClientJitterRecord, jitterMs, "jitter_ms", Float32),
+    LOG_COLUMN(ClientJitterRecord, delayMs, "delay_ms", Float32)
+};
+
+const std::vector<LogColumn> kServerStatsSchema = {
+    LOG_COLUMN(ServerStatsRecord, timestamp, "timestamp", Int64),
+    LOG_COLUMN(ServerStatsRecord, totalClients, "total_clients", Int32),
+    LOG_COLUMN(ServerStatsRecord, totalPackets, "total_packets", Int64),
+    LOG_COLUMN(ServerStatsRecord, avgJitterMs, "avg_jitter_ms", Float32)
+};
+
+#undef LOG_COLUMN
+
+size_t logColumnSize(LogColumnType type) {
+    switch (type) {
+        case LogColumnType::Int32: return 4;
+        case LogColumnType::Int64: return 8;
+        case LogColumnType::Float32: return 4;
+        case LogColumnType::Text32: return kLogTextBytes;
+    }
+    return 0;
+}
+
+BinaryLogWriter::BinaryLogWriter() : pending(0), lastFlushMs(0) {}
+
+BinaryLogWriter::~BinaryLogWriter() {
+    close();
+}
+
+bool BinaryLogWriter::open(const std::string& filename, const std::vector<LogColumn>& schema) {
+    close();
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    columns = schema;
+    columnData.assign(columns.size(), std::vector<char>());
+    for (size_t i = 0; i < columns.size(); i++) {
+        columnData[i].reserve(kRecordsPerBlock * logColumnSize(columns[i].type));
+    }
+    pending = 0;
+    lastFlushMs = steadyMs();
+
+    uint32_t columnCount = columns.size();
+    file.write(kLogMagic, sizeof(kLogMagic));
+    file.write(reinterpret_cast<const char*>(&columnCount), sizeof(columnCount));
+    for (const LogColumn& column : columns) {
+        uint8_t type = static_cast<uint8_t>(column.type);
+        uint8_t nameLength = column.name.size();
+        file.write(reinterpret_cast<const char*>(&type), 1);
+        file.write(reinterpret_cast<const char*>(&nameLength), 1);
+        file.write(column.name.data(), nameLength);
+    }
+    file.flush();
+    return file.good();
+}
+
+void BinaryLogWriter::append(const void* record) {
+    if (!file.is_open()) {
+        return;
+    }
+    const char* bytes = static_cast<const char*>(record);
+    for (size_t i = 0; i < columns.size(); i++) {
+        const char* field = bytes + columns[i].offset;
+        columnData[i].insert(columnData[i].end(), field, field + logColumnSize(columns[i].type));
+    }
+    if (++pending == kRecordsPerBlock) {
+        flush();
+    } else {
+        flushIfDue();
+    }
+}
+
+void BinaryLogWriter::flushIfDue() {
+    if (pending > 0 && steadyMs() - lastFlushMs >= kFlushIntervalMs) {
+        flush();
+    }
+}
+
+void BinaryLogWriter::flush() {
+    if (pending == 0 || !file.is_open()) {
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&pending), sizeof(pending));
+    for (std::vector<char>& data : columnData) {
+        file.write(data.data(), data.size());
+        data.clear();
+    }
+    file.flush();
+    pending = 0;
+    lastFlushMs = steadyMs();
+}
+
+void BinaryLogWriter::close() {
+    flush();
+    if (file.is_open()) {
+        file.close();
+    }
+}
+
+BinaryLogReader::BinaryLogReader() : data(NULL), size(0), cursor(0), blockRecords(0) {}
+
+BinaryLogReader::~BinaryLogReader() {
+    close();
+}
+
+bool BinaryLogReader::open(const std::string& filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(kLogMagic) + 4)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    data = static_cast<const char*>(mapped);
+    size = st.st_size;
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    if (memcmp(data, kLogMagic, sizeof(kLogMagic)) != 0) {
+        close();
+        return false;
+    }
+    cursor = sizeof(kLogMagic);
+    uint32_t columnCount;
+    memcpy(&columnCount, data + cursor, sizeof(columnCount));
+    cursor += sizeof(columnCount);
+
+    for (uint32_t i = 0; i < columnCount; i++) {
+        if (cursor + 2 > size) {
+            close();
+            return false;
+        }
+        LogColumn column;
+        column.type = static_cast<LogColumnType>(data[cursor]);
+        uint8_t nameLength = data[cursor + 1];
+        cursor += 2;
+        if (cursor + nameLength > size || logColumnSize(column.type) == 0) {
+            close();
+            return false;
+        }
+        column.name.assign(data + cursor, nameLength);
+        column.offset = 0;
+        cursor += nameLength;
+        columns.push_back(column);
+    }
+    blockColumns.resize(columns.size());
+    return true;
+}
+
+void BinaryLogReader::close() {
+    if (data != NULL) {
+        munmap(const_cast<char*>(data), size);
+    }
+    data = NULL;
+    size = 0;
+    cursor = 0;
+    columns.clear();
+    blockColumns.clear();
+    blockRecords = 0;
+}
+
+int BinaryLogReader::findColumn(const std::string& name) const {
+    for (size_t i = 0; i < columns.size(); i++) {
+        if (columns[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+size_t BinaryLogReader::rowSize() const {
+    size_t bytes = 0;
+    for (const LogColumn& column : columns) {
+        bytes += logColumnSize(column.type);
+    }
+    return bytes;
+}
+
+bool BinaryLogReader::nextBlock() {
+    blockRecords = 0;
+    if (data == NULL || cursor + sizeof(uint32_t) > size) {
+        return false;
+    }
+    uint32_t records;
+    memcpy(&records, data + cursor, sizeof(records));
+    size_t next = cursor + sizeof(records);
+    for (size_t i = 0; i < columns.size(); i++) {
+        blockColumns[i] = data + next;
+        next += static_cast<size_t>(records) * logColumnSize(columns[i].type);
+    }
+    if (next > size) {
+        return false; // Truncated block from a writer that did not shut down cleanly
+    }
+    cursor = next;
+    blockRecords = records;
+    return true;
+}
+
+double BinaryLogReader::value(int column, uint32_t row) const {
+    const char* base = blockColumns[column];
+    switch (columns[column].type) {
+        case LogColumnType::Int32: {
+            int32_t v;
+            memcpy(&v, base + row * 4, 4);
+            return v;
+        }
+        case LogColumnType::Int64: {
+            int64_t v;
+            memcpy(&v, base + row * 8, 8);
+            return static_cast<double>(v);
+        }
+        case LogColumnType::Float32: {
+            float v;
+            memcpy(&v, base + row * 4, 4);
+            return v;
+        }
+        case LogColumnType::Text32:
+            break;
+    }
+    return 0.0;
+}
+
+std::string BinaryLogReader::text(int column, uint32_t row) const {
+    if (columns[column].type != LogColumnType::Text32) {
+        return std::string();
+    }
+    const char* base = blockColumns[column] + row * kLogTextBytes;
+    return std::string(base, strnlen(base, kLogTextBytes));
+}
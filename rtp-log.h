@@ -0,0 +1,126 @@
+#ifndef RTP_LOG_H
+#define RTP_LOG_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+
+// Compact columnar binary log ("RTPLOG1").
+//
+// File layout:
+//   header: magic[8] "RTPLOG1\0", u32 columnCount,
+//           then per column: u8 type, u8 nameLength, name bytes
+//   blocks: u32 recordCount, then each column's values stored contiguously
+//           (recordCount * columnSize bytes per column), repeated until EOF
+// All integers are little-endian, as written by the host. Text32 values are
+// NUL-padded, and not terminated when all kLogTextBytes are used.
+
+const size_t kLogTextBytes = 32;
+
+enum class LogColumnType : uint8_t {
+    Int32 = 0,
+    Int64 = 1,
+    Float32 = 2,
+    Text32 = 3
+};
+
+struct LogColumn {
+    std::string name;
+    LogColumnType type;
+    size_t offset; // Offset of the field inside the record struct
+};
+
+size_t logColumnSize(LogColumnType type);
+
+// Records the server and client produce; field names match the CSV columns
+struct ServerJitterRecord {
+    int64_t timestamp;   // Receive time, milliseconds since the epoch
+    int32_t packetId;    // Per-client packet counter on the server
+    int32_t sequence;    // Sequence number from the sender's header
+    float jitterMs;
+    float delayMs;
+};
+
+struct ClientJitterRecord {
+    int64_t timestamp;
+    int32_t packetId;
+    char source[kLogTextBytes]; // Sender from the header: "server" or a forwarded stream
+    int32_t sequence;    // Sequence number from the sender's header
+    int32_t bufferSize;
+    float processingTimeMs;
+    float jitterMs;
+    float delayMs;
+};
+
+struct ServerStatsRecord {
+    int64_t timestamp;
+    int32_t totalClients;
+    int64_t totalPackets;
+    float avgJitterMs;
+};
+
+extern const std::vector<LogColumn> kServerJitterSchema;
+extern const std::vector<LogColumn> kClientJitterSchema;
+extern const std::vector<LogColumn> kServerStatsSchema;
+
+// Buffers records column by column and writes one block per kRecordsPerBlock
+// records, or sooner once kFlushIntervalMs has passed so a killed process loses
+// at most about a second of data. The interval is checked on append() and
+// flushIfDue(); owners call the latter while idle so a quiet log is written too.
+class BinaryLogWriter {
+public:
+    static const uint32_t kRecordsPerBlock = 4096;
+    static const int64_t kFlushIntervalMs = 1000;
+
+    BinaryLogWriter();
+    ~BinaryLogWriter();
+    BinaryLogWriter(BinaryLogWriter&&) = default;
+    BinaryLogWriter& operator=(BinaryLogWriter&&) = default;
+
+    bool open(const std::string& filename, const std::vector<LogColumn>& schema);
+    bool is_open() const { return file.is_open(); }
+    void append(const void* record); // Record must match the schema passed to open()
+    void flush(); // Writes any buffered records as a (short) block
+    void flushIfDue(); // flush() once kFlushIntervalMs has passed since the last block
+    void close();
+
+private:
+    std::ofstream file;
+    std::vector<LogColumn> columns;
+    std::vector<std::vector<char>> columnData;
+    uint32_t pending;
+    int64_t lastFlushMs;
+};
+
+// Read-only mmap view of a binary log, walked one block at a time
+class BinaryLogReader {
+public:
+    BinaryLogReader();
+    ~BinaryLogReader();
+
+    bool open(const std::string& filename);
+    void close();
+
+    const std::vector<LogColumn>& schema() const { return columns; }
+    int findColumn(const std::string& name) const; // -1 if absent
+    size_t fileSize() const { return size; }
+    size_t rowSize() const; // Bytes one record occupies across all columns
+
+    // Advances to the next block; returns false at the end or on truncation
+    bool nextBlock();
+    uint32_t blockSize() const { return blockRecords; }
+    double value(int column, uint32_t row) const; // 0 for text columns
+    std::string text(int column, uint32_t row) const; // Text32 columns only
+
+private:
+    const char* data;
+    size_t size;
+    size_t cursor;
+    std::vector<LogColumn> columns;
+    std::vector<const char*> blockColumns;
+    uint32_t blockRecords;
+};
+
+#endif // RTP_LOG_H
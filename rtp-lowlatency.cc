@@ -0,0 +1,98 @@
+#include "rtp-lowlatency.h"
+#include <iostream>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+#ifndef MPOL_LOCAL
+#define MPOL_LOCAL 4
+#endif
+
+bool parseLowLatencyOption(const std::string& option, LowLatencyConfig& config, std::vector<int>& cpus) {
+    cpus.clear();
+    if (option == "lowlatency") {
+        config.enabled = true;
+        return true;
+    }
+    if (option.compare(0, 11, "lowlatency:") != 0) {
+        std::cerr << "Unknown option " << option << ", expected lowlatency[:<cpu>[,<cpu>...]]" << std::endl;
+        return false;
+    }
+
+    std::string list = option.substr(11);
+    size_t start = 0;
+    while (true) {
+        size_t end = list.find(',', start);
+        std::string item = list.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        if (item.empty() || item.size() > 5 || item.find_first_not_of("0123456789") != std::string::npos ||
+            std::stoi(item) >= CPU_SETSIZE) {
+            std::cerr << "Invalid CPU '" << item << "' in " << option << ", expected numbers 0-"
+                      << CPU_SETSIZE - 1 << std::endl;
+            return false;
+        }
+        cpus.push_back(std::stoi(item));
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    config.enabled = true;
+    return true;
+}
+
+bool placeCurrentThread(int cpu, const std::string& name) {
+    if (cpu < 0) {
+        return true;
+    }
+    if (cpu >= CPU_SETSIZE) {
+        std::cerr << name << ": CPU " << cpu << " is out of range" << std::endl;
+        return false;
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (err != 0) {
+        std::cerr << name << ": failed to pin to CPU " << cpu << ": " << strerror(err) << std::endl;
+        return false;
+    }
+
+    // Allocate from the node we now run on, even if the default policy was changed
+    if (syscall(SYS_set_mempolicy, MPOL_LOCAL, NULL, 0) != 0) {
+        perror("set_mempolicy failed");
+    }
+
+    unsigned currentCpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &currentCpu, &node, NULL) == 0) {
+        std::cout << name << " pinned to CPU " << currentCpu << " (NUMA node " << node << ")" << std::endl;
+    }
+    return true;
+}
+
+void enableSpinPolling(int sockfd, int busyPollUsec) {
+    int flags = fcntl(sockfd, F_GETFL, 0);
+    if (flags < 0 || fcntl(sockfd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        perror("Failed to make socket non-blocking");
+    }
+
+    // Raising SO_BUSY_POLL needs CAP_NET_ADMIN; the user-space spin works without it
+    if (busyPollUsec > 0 &&
+        setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, &busyPollUsec, sizeof(busyPollUsec)) < 0) {
+        perror("SO_BUSY_POLL unavailable, spinning in user space only");
+    }
+}
+
+bool wouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
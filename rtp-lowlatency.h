@@ -0,0 +1,45 @@
+#ifndef RTP_LOWLATENCY_H
+#define RTP_LOWLATENCY_H
+
+#include <string>
+#include <vector>
+
+// Low-latency mode trades a dedicated core for wakeup latency: the receiving
+// thread is pinned, allocates from its own NUMA node and spins on a
+// non-blocking socket (optionally with kernel busy polling) instead of sleeping
+// in recvfrom().
+struct LowLatencyConfig {
+    bool enabled;
+    int receiveCpu;     // CPU for the server receive thread, -1 to leave unpinned
+    int workerCpu;      // CPU for the client packet processing thread, -1 to leave unpinned
+    int busyPollUsec;   // SO_BUSY_POLL budget, 0 to spin in user space only
+
+    LowLatencyConfig() : enabled(false), receiveCpu(-1), workerCpu(-1), busyPollUsec(50) {}
+};
+
+// Parses "lowlatency" or "lowlatency:<cpu>[,<cpu>...]" (as used on the command
+// line) into the listed CPUs, empty to leave threads unpinned. Enables config;
+// the caller decides which thread gets which CPU. Prints why and returns false
+// for anything else, e.g. "lowlatency:abc".
+bool parseLowLatencyOption(const std::string& option, LowLatencyConfig& config, std::vector<int>& cpus);
+
+// Pins the calling thread to cpu and makes its later allocations NUMA-local.
+// Does nothing for cpu < 0. Returns false if pinning failed.
+bool placeCurrentThread(int cpu, const std::string& name);
+
+// Makes sockfd non-blocking and asks the kernel to busy poll for busyPollUsec
+void enableSpinPolling(int sockfd, int busyPollUsec);
+
+// True if the last receive failed only because nothing was queued yet
+bool wouldBlock();
+
+// Pause hint for spin loops
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+#endif // RTP_LOWLATENCY_H
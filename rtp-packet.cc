@@ -0,0 +1,59 @@
+#include "rtp-packet.h"
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+std::string buildPacket(const RTPHeader& header, const std::string& payload) {
+    char ssrc[24] = "";
+    if (header.ssrc != 0) {
+        snprintf(ssrc, sizeof(ssrc), "|%llx", static_cast<unsigned long long>(header.ssrc));
+    }
+    return "[" + header.source + "|" + std::to_string(header.sequence) + "|" +
+           std::to_string(header.sendTimeNs) + ssrc + "] " + payload;
+}
+
+size_t formatHeader(const char* source, int sequence, int64_t sendTimeNs, uint64_t ssrc, char* out, size_t cap) {
+    int written = ssrc != 0 ?
+        snprintf(out, cap, "[%s|%d|%lld|%llx] ", source, sequence, static_cast<long long>(sendTimeNs),
+                 static_cast<unsigned long long>(ssrc)) :
+        snprintf(out, cap, "[%s|%d|%lld] ", source, sequence, static_cast<long long>(sendTimeNs));
+    if (written < 0) {
+        return 0;
+    }
+    return static_cast<size_t>(written) < cap ? static_cast<size_t>(written) : cap - 1;
+}
+
+bool parsePacket(const char* data, size_t len, RTPHeader& header, size_t& payloadOffset) {
+    if (len < 2 || data[0] != '[') {
+        return false;
+    }
+    const char* end = static_cast<const char*>(memchr(data, ']', len));
+    if (end == NULL) {
+        return false;
+    }
+    const char* firstBar = static_cast<const char*>(memchr(data, '|', end - data));
+    if (firstBar == NULL) {
+        return false;
+    }
+
+    header.source.assign(data + 1, firstBar - data - 1);
+    char* next = NULL;
+    header.sequence = static_cast<int>(strtol(firstBar + 1, &next, 10));
+    header.sendTimeNs = 0;
+    header.ssrc = 0;
+    if (next < end && *next == '|') {
+        header.sendTimeNs = strtoll(next + 1, &next, 10);
+    }
+    if (next < end && *next == '|') {
+        header.ssrc = strtoull(next + 1, &next, 16);
+    }
+    if (next != end) {
+        return false;
+    }
+
+    payloadOffset = (end - data) + 1;
+    if (payloadOffset < len && data[payloadOffset] == ' ') {
+        payloadOffset++;
+    }
+    return true;
+}
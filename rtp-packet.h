@@ -0,0 +1,32 @@
+#ifndef RTP_PACKET_H
+#define RTP_PACKET_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Text header carried in front of every payload: "[source|sequence|sendTimeNs] payload",
+// or "[source|sequence|sendTimeNs|ssrc] payload" with ssrc in hex for SRTP streams
+struct RTPHeader {
+    std::string source;  // Client identifier, or "server"
+    int sequence;
+    int64_t sendTimeNs;  // Sender CLOCK_REALTIME in nanoseconds, 0 if unknown
+    uint64_t ssrc;       // Random 48-bit SRTP stream id, 0 if not carried
+
+    RTPHeader() : sequence(0), sendTimeNs(0), ssrc(0) {}
+};
+
+// Receive buffer size: fits a 1200-byte payload with its header and SRTP tag
+const size_t kMaxPacketSize = 2048;
+
+std::string buildPacket(const RTPHeader& header, const std::string& payload);
+
+// Writes just the header (with its trailing space) into out without allocating;
+// ssrc 0 is left out. Returns the number of bytes written, truncated to fit cap.
+size_t formatHeader(const char* source, int sequence, int64_t sendTimeNs, uint64_t ssrc, char* out, size_t cap);
+
+// Parses the header at the start of data. The legacy "[source|sequence]" form
+// is accepted with sendTimeNs left at 0. Returns false if there is no header.
+bool parsePacket(const char* data, size_t len, RTPHeader& header, size_t& payloadOffset);
+
+#endif // RTP_PACKET_H
@@ -0,0 +1,111 @@
+#include "rtp-pipeline.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+
+// Measures the cost per packet of the server pipeline with every stage enabled
+// against the minimal instantiation. Packets come from memory and sends and
+// delays are only counted, so the numbers are pipeline CPU time without syscalls
+// or simulated sleeps.
+//
+// Usage: rtp-pipeline-bench [packets] [clients]
+
+struct MemoryIO {
+    const std::vector<std::string>* packets;
+    const std::vector<struct sockaddr_in>* sources;
+    size_t next;
+    unsigned long long bytesSent;
+    unsigned long long delayedMs;
+
+    MemoryIO(const std::vector<std::string>& packetList, const std::vector<struct sockaddr_in>& sourceList)
+        : packets(&packetList), sources(&sourceList), next(0), bytesSent(0), delayedMs(0) {}
+
+    int receive(char* buffer, size_t len, struct sockaddr_in* addr, socklen_t* addrLen, ReceiveTime& recvTime) {
+        size_t index = next++ % packets->size();
+        const std::string& packet = (*packets)[index];
+        size_t size = std::min(len, packet.size());
+        memcpy(buffer, packet.data(), size);
+        *addr = (*sources)[index];
+        *addrLen = sizeof(*addr);
+        recvTime.ns = monotonicWallNs();
+        recvTime.source = TimestampSource::Monotonic;
+        return static_cast<int>(size);
+    }
+
+    void send(const std::string& packet, const struct sockaddr_in&, socklen_t) {
+        bytesSent += packet.size();
+    }
+
+    void delay(int ms) {
+        delayedMs += ms;
+    }
+};
+
+template <class Fec, class Congestion, class Log>
+static double runBenchmark(const std::string& name, size_t count,
+                           const std::vector<std::string>& packets,
+                           const std::vector<struct sockaddr_in>& sources) {
+    RTPServer server(0);
+    MemoryIO io(packets, sources);
+
+    // Console output still gets formatted, it just goes nowhere
+    std::ofstream devNull("/dev/null");
+    std::streambuf* original = std::cout.rdbuf(devNull.rdbuf());
+
+    for (size_t i = 0; i < packets.size(); i++) {
+        ServerPipeline<Fec, Congestion, Log, MemoryIO>::receivePacket(server, io); // Warm up, create clients
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        ServerPipeline<Fec, Congestion, Log, MemoryIO>::receivePacket(server, io);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout.rdbuf(original);
+    double nsPerPacket = std::chrono::duration<double, std::nano>(end - start).count() / count;
+    std::cout << "  " << name << ": " << nsPerPacket << " ns/packet ("
+              << 1e9 / nsPerPacket << " packets/s, " << io.delayedMs << " ms of simulated delay skipped)" << std::endl;
+    return nsPerPacket;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 200000;
+    int clientCount = argc > 2 ? std::stoi(argv[2]) : 64;
+
+    // Logs written by the full pipeline go to a scratch directory
+    char scratch[] = "/tmp/rtp-pipeline-bench-XXXXXX";
+    if (mkdtemp(scratch) == NULL || chdir(scratch) != 0) {
+        perror("Failed to create scratch directory");
+        return 1;
+    }
+
+    std::vector<std::string> packets;
+    std::vector<struct sockaddr_in> sources;
+    for (int i = 0; i < clientCount; i++) {
+        RTPHeader header;
+        header.source = "client_" + std::to_string(i);
+        header.sequence = i;
+        header.sendTimeNs = wallClockNs();
+        packets.push_back(buildPacket(header, std::string(100, 'p')));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(0x0a000001 + i);
+        addr.sin_port = htons(5000 + i);
+        sources.push_back(addr);
+    }
+
+    std::cout << "Pipeline benchmark: " << count << " packets from " << clientCount
+              << " clients (logs in " << scratch << ")" << std::endl;
+    double full = runBenchmark<RepeatFec, SimulatedCongestion, FileLogging>("full (FEC + congestion + logging)", count, packets, sources);
+    runBenchmark<NoFec, NoCongestion, FileLogging>("logging only", count, packets, sources);
+    runBenchmark<RepeatFec, SimulatedCongestion, NoLogging>("FEC + congestion, no logging", count, packets, sources);
+    double minimal = runBenchmark<NoFec, NoCongestion, NoLogging>("minimal (no-op policies)", count, packets, sources);
+    std::cout << "Full pipeline costs " << full / minimal << "x the minimal one" << std::endl;
+    return 0;
+}
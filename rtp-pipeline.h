@@ -0,0 +1,269 @@
+#ifndef RTP_PIPELINE_H
+#define RTP_PIPELINE_H
+
+#include "rtp-server.h"
+#include "rtp-lowlatency.h"
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <random>
+
+// The server packet pipeline, specialized at compile time over four policies:
+//   Fec        - what is remembered and sent as FEC per packet
+//   Congestion - simulated network jitter and congestion delays
+//   Log        - console output, per-client jitter logs and server stats
+//   Io         - how datagrams are received, sent and delayed
+// Every hook of the No* policies is an empty inline function, so a pipeline
+// instantiated with them contains none of that stage's code. RTPServer picks
+// one pre-instantiated pipeline from a dispatch table when its settings change.
+// SRTP, packet capture and SFU forwarding are not policies: they stay runtime
+// checks (srtpEnabled, capture.is_open(), forwardingEnabled) in every pipeline,
+// one predictable branch per packet each, to keep the table at 2x2x2 entries.
+
+// ---- FEC policies ----
+
+struct NoFec {
+    static void onPacket(ClientData&, const char*, std::string&) {}
+};
+
+// Repeats packet N-3 as an FEC packet after every 4th packet
+struct RepeatFec {
+    static void onPacket(ClientData& client, const char* buffer, std::string& fecPacket) {
+        client.packetHistory[client.packetCounter] = buffer;
+        if (client.packetCounter % 4 == 0 && client.packetCounter > 0) {
+            fecPacket = "FEC_PACKET: " + client.packetHistory[client.packetCounter - 3];
+        }
+        // Only the last few packets can ever be repeated
+        client.packetHistory.erase(client.packetCounter - 3);
+    }
+};
+
+// ---- Congestion policies ----
+
+struct NoCongestion {
+    static int networkJitterMs() { return 0; }
+    static int sendDelayMs(const ClientData&) { return 0; }
+};
+
+struct SimulatedCongestion {
+    // Simulate jitter with random delay (0-100ms)
+    static int networkJitterMs() {
+        static std::mt19937 gen(std::random_device{}());
+        std::uniform_int_distribution<int> jitterDist(0, 100);
+        return jitterDist(gen);
+    }
+
+    // Simulate congestion by adding delay if packet rate is too high
+    static int sendDelayMs(const ClientData& client) {
+        return client.packetCounter % 5 == 0 ? 200 : 0;
+    }
+};
+
+// ---- Logging policies ----
+
+struct NoLogging {
+    static void onNewClient(RTPServer&, const std::string&, ClientData&) {}
+    static void onPacket(RTPServer&, const std::string&, ClientData&, const char*,
+                         const RTPHeader&, const ReceiveTime&, double) {}
+    static void onStats(RTPServer&, const ReceiveTime&) {}
+    static void onCongestion(const std::string&) {}
+    static void onSend(const std::string&, const std::string&) {}
+};
+
+struct FileLogging {
+    static void onNewClient(RTPServer& server, const std::string& clientKey, ClientData& client);
+    static void onPacket(RTPServer& server, const std::string& clientKey, ClientData& client,
+                         const char* buffer, const RTPHeader& header, const ReceiveTime& recvTime,
+                         double delayMs);
+    static void onStats(RTPServer& server, const ReceiveTime& recvTime);
+
+    static void onCongestion(const std::string& clientKey) {
+        std::cout << "Simulated congestion for " << clientKey << "! Introducing delay..." << std::endl;
+    }
+
+    static void onSend(const std::string& clientKey, const std::string& message) {
+        std::cout << "Sent to " << clientKey << ": " << message << std::endl;
+    }
+};
+
+// ---- I/O policies ----
+
+struct SocketIO {
+    int sockfd;
+
+    explicit SocketIO(int fd) : sockfd(fd) {}
+
+    // Returns -1 with wouldBlock() on the idle timeout or, in low-latency mode, when
+    // nothing is queued yet; RTPServer::start() then simply calls again (spinning)
+    int receive(char* buffer, size_t len, struct sockaddr_in* addr, socklen_t* addrLen, ReceiveTime& recvTime) {
+        int bytesReceived = recvWithTimestamp(sockfd, buffer, len, addr, addrLen, recvTime);
+        if (bytesReceived < 0 && wouldBlock()) {
+            cpuRelax();
+        }
+        return bytesReceived;
+    }
+
+    void send(const std::string& packet, const struct sockaddr_in& addr, socklen_t addrLen) {
+        sendto(sockfd, packet.c_str(), packet.size(), 0, (const struct sockaddr*)&addr, addrLen);
+    }
+
+    void delay(int ms) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+};
+
+// ---- Pipeline ----
+
+template <class Fec, class Congestion, class Log, class Io>
+struct ServerPipeline {
+    // Entry points used by RTPServer's dispatch table
+    static void run(RTPServer& server) {
+        Io io(server.sockfd);
+        receivePacket(server, io);
+    }
+
+    static void send(RTPServer& server, const std::string& message, struct sockaddr_in& clientAddr, socklen_t clientLen) {
+        Io io(server.sockfd);
+        sendPacket(server, io, message, clientAddr, clientLen);
+    }
+
+    static void receivePacket(RTPServer& server, Io& io) {
+        char buffer[kMaxPacketSize];
+
+        struct sockaddr_in clientAddr;
+        socklen_t clientLen = sizeof(clientAddr);
+
+        ReceiveTime recvTime;
+        int bytesReceived = io.receive(buffer, sizeof(buffer) - 1, &clientAddr, &clientLen, recvTime);
+        if (bytesReceived < 0) {
+            // Idle, or interrupted by a stop signal
+            if (!wouldBlock() && errno != EINTR) {
+                perror("Receive failed");
+            }
+            return;
+        }
+        buffer[bytesReceived] = '\0';
+
+        RTPHeader header;
+        size_t payloadOffset = 0;
+        bool parsed = parsePacket(buffer, bytesReceived, header, payloadOffset);
+
+        // Anything that is not authentic, fresh SRTP stops here
+        if (server.srtpEnabled) {
+            size_t length = bytesReceived;
+            if (!parsed || !server.srtpIn.unprotect(buffer, length, payloadOffset, header, clientAddr)) {
+                return;
+            }
+            bytesReceived = static_cast<int>(length);
+            buffer[bytesReceived] = '\0';
+        }
+
+        // Captured after unprotect so the trace holds plaintext that rtp-replay can seal again
+        if (server.capture.is_open()) {
+            server.capturePacket(recvTime, clientAddr, bytesReceived, parsed, header,
+                                 buffer + payloadOffset, bytesReceived - payloadOffset);
+        }
+
+        // In forwarding mode packets are fanned out to subscribers instead of acknowledged
+        if (server.forwardingEnabled && parsed) {
+            const char* payload = buffer + payloadOffset;
+            size_t payloadLen = bytesReceived - payloadOffset;
+            if (!server.handleSubscription(payload, payloadLen, clientAddr)) {
+                server.forwardPacket(header, payload, payloadLen);
+            }
+            return;
+        }
+
+        int simulatedJitter = Congestion::networkJitterMs();
+        std::string clientKey = server.getClientKey(clientAddr);
+
+        // Thread-safe access to clients map
+        server.clientsMutex.lock();
+
+        // If this is a new client, set up their data
+        auto it = server.clients.find(clientKey);
+        if (it == server.clients.end()) {
+            it = server.clients.insert(std::make_pair(clientKey, ClientData())).first;
+            ClientData& client = it->second;
+            client.addr = clientAddr;
+            client.addrLen = clientLen;
+
+            char ipStr[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &(clientAddr.sin_addr), ipStr, INET_ADDRSTRLEN);
+            client.clientIP = ipStr;
+            client.clientPort = ntohs(clientAddr.sin_port);
+            Log::onNewClient(server, clientKey, client);
+        }
+        ClientData& client = it->second;
+
+        // Measure jitter and one-way delay against the sender's timestamp
+        double delayMs = 0.0;
+        if (parsed && header.sendTimeNs > 0) {
+            delayMs = client.jitter.update(header.sendTimeNs, recvTime) / 1e6;
+        }
+        Log::onPacket(server, clientKey, client, buffer, header, recvTime, delayMs);
+
+        // FEC packet is sent after unlocking, sendPacket takes clientsMutex
+        std::string fecPacket;
+        Fec::onPacket(client, buffer, fecPacket);
+
+        client.packetCounter++;
+        server.clientsMutex.unlock();
+
+        if (!fecPacket.empty()) {
+            sendPacket(server, io, fecPacket, clientAddr, clientLen);
+        }
+
+        if (simulatedJitter > 0) {
+            io.delay(simulatedJitter);
+        }
+
+        Log::onStats(server, recvTime);
+
+        // Send acknowledgment
+        sendPacket(server, io, "Acknowledged", clientAddr, clientLen);
+    }
+
+    static void sendPacket(RTPServer& server, Io& io, const std::string& message,
+                           struct sockaddr_in& clientAddr, socklen_t clientLen) {
+        std::string clientKey = server.getClientKey(clientAddr);
+
+        int congestionDelay = 0;
+        RTPHeader header;
+        header.source = "server";
+
+        // With SRTP every client gets its own randomly numbered stream, so no two packets share a nonce
+        server.clientsMutex.lock();
+        auto it = server.clients.find(clientKey);
+        if (it != server.clients.end()) {
+            congestionDelay = Congestion::sendDelayMs(it->second);
+            header.sequence = it->second.sendSequence++;
+            if (server.srtpEnabled && it->second.srtpSsrc == 0) {
+                it->second.srtpSsrc = newSrtpSsrc();
+            }
+            header.ssrc = it->second.srtpSsrc;
+        } else if (server.srtpEnabled) {
+            header.sequence = server.controlSequence++;
+            header.ssrc = server.controlSsrc;
+        }
+        server.clientsMutex.unlock();
+
+        if (congestionDelay > 0) {
+            Log::onCongestion(clientKey);
+            io.delay(congestionDelay);
+        }
+
+        // Stamp as late as possible so the client measures only network delay
+        header.sendTimeNs = wallClockNs();
+        std::string packet = buildPacket(header, message);
+        if (server.srtpEnabled && !server.srtpOut.protect(packet, packet.size() - message.size(), header)) {
+            return;
+        }
+        io.send(packet, clientAddr, clientLen);
+        Log::onSend(clientKey, message);
+    }
+};
+
+#endif // RTP_PIPELINE_H
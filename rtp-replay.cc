@@ -0,0 +1,182 @@
+#include "rtp-trace.h"
+#include "rtp-packet.h"
+#include "rtp-timestamp.h"
+#include "rtp-srtp.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <cstdlib>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+// Drives an RTP server from a trace recorded with RTPServer::enableCapture().
+// Every original source address gets its own socket so the server sees the
+// same set of clients, and each packet is rebuilt with the recorded source,
+// sequence, payload prefix and payload size (the rest is filler) and a fresh send time.
+// With srtp every source is sealed under its own new random SSRC.
+//
+// Usage: rtp-replay <trace> [server-ip] [port] [speed] [srtp[:cm]]
+//   speed: 1 (recorded timing, default), any multiple such as 2.5, or "max"
+//   srtp:  for servers started with srtp; the key is read from RTP_SRTP_KEY
+
+static int64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void sleepUntil(int64_t deadlineNs) {
+    struct timespec ts;
+    ts.tv_sec = deadlineNs / 1000000000LL;
+    ts.tv_nsec = deadlineNs % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+        // Interrupted by a signal, keep waiting
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <trace> [server-ip] [port] [speed|max] [srtp[:cm]]" << std::endl;
+        return 1;
+    }
+    std::string traceFile = argv[1];
+    std::string serverIP = argc > 2 ? argv[2] : "127.0.0.1";
+    int port = argc > 3 ? std::stoi(argv[3]) : 8080;
+    bool asFastAsPossible = argc > 4 && std::string(argv[4]) == "max";
+    double speed = (argc > 4 && !asFastAsPossible) ? std::stod(argv[4]) : 1.0;
+    if (speed <= 0.0) {
+        std::cerr << "Speed must be positive" << std::endl;
+        return 1;
+    }
+    SrtpProfile srtpProfile = SrtpProfile::AeadAes128Gcm;
+    SrtpContext srtp;
+    if (argc > 5) {
+        const char* key = getenv("RTP_SRTP_KEY");
+        if (!parseSrtpOption(argv[5], srtpProfile)) {
+            std::cerr << "Unknown option " << argv[5] << ", expected srtp or srtp:cm" << std::endl;
+            return 1;
+        }
+        if (key == NULL || !srtp.init(srtpProfile, key)) {
+            std::cerr << "SRTP needs the session's master key and salt in hex in RTP_SRTP_KEY" << std::endl;
+            return 1;
+        }
+    }
+
+    TraceReader trace;
+    if (!trace.open(traceFile)) {
+        std::cerr << "Failed to open trace " << traceFile << std::endl;
+        return 1;
+    }
+    if (trace.size() == 0) {
+        std::cout << "Trace is empty" << std::endl;
+        return 0;
+    }
+
+    struct sockaddr_in serverAddr;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(port);
+    if (inet_pton(AF_INET, serverIP.c_str(), &serverAddr.sin_addr) <= 0) {
+        perror("Invalid server address");
+        return 1;
+    }
+
+    // One socket (and SSRC) per recorded source, created up front so setup is not timed
+    std::map<uint64_t, int> sockets;
+    std::map<uint64_t, uint64_t> ssrcs;
+    for (uint64_t i = 0; i < trace.size(); i++) {
+        uint64_t key = (static_cast<uint64_t>(trace[i].srcAddr) << 16) | trace[i].srcPort;
+        if (sockets.find(key) == sockets.end()) {
+            int fd = socket(AF_INET, SOCK_DGRAM, 0);
+            if (fd < 0) {
+                perror("Socket creation failed");
+                return 1;
+            }
+            sockets[key] = fd;
+            ssrcs[key] = srtp.is_open() ? newSrtpSsrc() : 0;
+        }
+    }
+
+    std::cout << "Replaying " << trace.size() << " packets from " << sockets.size() << " sources to "
+              << serverIP << ":" << port << " at "
+              << (asFastAsPossible ? std::string("max") : std::to_string(speed) + "x") << " speed"
+              << (srtp.is_open() ? std::string(" with ") + srtpProfileName(srtpProfile) : "") << std::endl;
+
+    std::string packet;
+    std::string filler(65536, 'x');
+    uint64_t sent = 0;
+    uint64_t failed = 0;
+    int64_t maxLagNs = 0;
+    double totalLagNs = 0.0;
+    const int64_t firstArrival = trace[0].arrivalNs;
+    const int64_t startNs = monotonicNs();
+
+    for (uint64_t i = 0; i < trace.size(); i++) {
+        const TraceRecord& record = trace[i];
+
+        if (!asFastAsPossible) {
+            int64_t offset = static_cast<int64_t>((record.arrivalNs - firstArrival) / speed);
+            int64_t deadline = startNs + std::max<int64_t>(offset, 0);
+            int64_t now = monotonicNs();
+            if (now < deadline) {
+                sleepUntil(deadline);
+                now = monotonicNs();
+            }
+            int64_t lag = now - deadline;
+            maxLagNs = std::max(maxLagNs, lag);
+            totalLagNs += lag;
+        }
+
+        // Rebuild the packet at its recorded size
+        uint64_t key = (static_cast<uint64_t>(record.srcAddr) << 16) | record.srcPort;
+        RTPHeader header;
+        if (record.flags & kTraceHasHeader) {
+            header.source.assign(record.source, strnlen(record.source, sizeof(record.source)));
+            header.sequence = record.sequence;
+            header.sendTimeNs = record.sendTimeNs != 0 ? wallClockNs() : 0;
+            header.ssrc = ssrcs[key];
+            packet = buildPacket(header, "");
+        } else {
+            packet.clear();
+        }
+        size_t headerLen = packet.size();
+        // Only the uncaptured rest of a long payload is filler; the rebuilt header's
+        // length may differ from the original, so record.size is not used here
+        size_t captured = std::min<size_t>(record.capturedLen, kTracePayloadBytes);
+        packet.append(record.payload, captured);
+        if (record.payloadLen > captured) {
+            packet.append(filler, 0, record.payloadLen - captured);
+        }
+        if (srtp.is_open() && !srtp.protect(packet, headerLen, header)) {
+            failed++;
+            continue;
+        }
+
+        if (sendto(sockets[key], packet.data(), packet.size(), 0,
+                   (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+            failed++;
+        } else {
+            sent++;
+        }
+    }
+
+    double elapsedSec = (monotonicNs() - startNs) / 1e9;
+    double recordedSec = (trace[trace.size() - 1].arrivalNs - firstArrival) / 1e9;
+    std::cout << "Sent " << sent << " packets (" << failed << " failed) in " << elapsedSec << "s"
+              << " (recorded span " << recordedSec << "s, " << (elapsedSec > 0 ? sent / elapsedSec : 0.0)
+              << " packets/s)" << std::endl;
+    if (!asFastAsPossible) {
+        std::cout << "Schedule lag: mean " << (totalLagNs / trace.size()) / 1000.0 << "us, max "
+                  << maxLagNs / 1000.0 << "us" << std::endl;
+    }
+
+    for (auto& entry : sockets) {
+        close(entry.second);
+    }
+    return 0;
+}
@@ -1,5 +1,9 @@
 #include "rtp-server.h"
 #include <thread>
+#include <cstdlib>
+#include <vector>
+#include <csignal>
+#include <cstring>
 
 // For NS-3 simulation, include these headers
 // #include "ns3/core-module.h"
@@ -9,6 +13,20 @@
 // #include "ns3/applications-module.h"
 // #include "ns3/error-model.h"
 
+static RTPServer* activeServer = NULL;
+
+// SIGINT/SIGTERM end the receive loop so the logs and the trace are closed on exit
+static void stopServer(int) {
+    if (activeServer != NULL) {
+        activeServer->stop();
+    }
+}
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [port] [sfu] [binlog] [capture] [fwdrate:<bytes/s>]"
+              << " [lowlatency[:cpu]] [srtp[:cm]]" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     int port = 8080;  // Default server port
     
@@ -16,6 +34,51 @@ int main(int argc, char* argv[]) {
     if (argc > 1) {
         port = std::stoi(argv[1]);
     }
+    // Optional modes after the port: "sfu" (forwarding), "binlog" (binary logs),
+    // "capture" (packet trace for rtp-replay), "lowlatency[:cpu]" (pinned spin-polling),
+    // "srtp[:cm]" (encryption, master key and salt in hex from RTP_SRTP_KEY),
+    // "fwdrate:<bytes/s>" (per-subscriber forwarding cap)
+    bool forwarding = false;
+    double forwardRate = 0.0;
+    bool binaryLogs = false;
+    bool capture = false;
+    LowLatencyConfig lowLatency;
+    bool srtp = false;
+    SrtpProfile srtpProfile = SrtpProfile::AeadAes128Gcm;
+    for (int i = 2; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "sfu") {
+            forwarding = true;
+        } else if (option == "binlog") {
+            binaryLogs = true;
+        } else if (option == "capture") {
+            capture = true;
+        } else if (parseSrtpOption(option, srtpProfile)) {
+            srtp = true;
+        } else if (option.compare(0, 10, "lowlatency") == 0) {
+            std::vector<int> cpus;
+            if (!parseLowLatencyOption(option, lowLatency, cpus)) {
+                return 1;
+            }
+            if (cpus.size() > 1) {
+                std::cerr << "The server has one receive thread, give lowlatency a single CPU" << std::endl;
+                return 1;
+            }
+            lowLatency.receiveCpu = cpus.empty() ? -1 : cpus[0];
+        } else if (option.compare(0, 8, "fwdrate:") == 0) {
+            std::string rate = option.substr(8);
+            if (rate.empty() || rate.size() > 12 || rate.find_first_not_of("0123456789") != std::string::npos) {
+                std::cerr << "Invalid rate in " << option << ", expected fwdrate:<bytes per second>" << std::endl;
+                return 1;
+            }
+            forwardRate = std::stod(rate);
+        } else {
+            // A mistyped mode must not silently start without it (e.g. plaintext for "srtp:CM")
+            std::cerr << "Unknown option " << option << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
     
     std::cout << "Starting RTP Server on port " << port << std::endl;
     
@@ -24,6 +87,28 @@ int main(int argc, char* argv[]) {
     // Enable features
     server.enableFEC(true);
     server.enableCongestionControl(true);
+    if (forwarding) {
+        server.enableForwarding(true); // Fan each stream out to its subscribers
+    }
+    if (forwardRate > 0.0) {
+        server.setForwardRateLimit(forwardRate);
+    }
+    if (binaryLogs) {
+        server.enableBinaryLogs(true); // Compact logs for rtp-log-analyzer
+    }
+    if (capture) {
+        server.enableCapture("server_trace.rtptrace");
+    }
+    if (lowLatency.enabled) {
+        server.enableLowLatency(lowLatency);
+    }
+    if (srtp) {
+        const char* key = getenv("RTP_SRTP_KEY");
+        if (key == NULL || !server.enableSrtp(srtpProfile, key)) {
+            std::cerr << "SRTP needs the session's master key and salt in hex in RTP_SRTP_KEY" << std::endl;
+            return 1;
+        }
+    }
 
     // For NS-3 simulation
     /*
@@ -50,7 +135,17 @@ int main(int argc, char* argv[]) {
     Ipv4InterfaceContainer interfaces = address.Assign(devices);
     */
 
+    // No SA_RESTART, so a blocked receive returns at once
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopServer;
+    sigemptyset(&action.sa_mask);
+    activeServer = &server;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
     server.start(); // Start RTP Server (this will run in the main thread)
+    activeServer = NULL;
 
     return 0;
 }
\ No newline at end of file
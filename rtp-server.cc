@@ -1,23 +1,40 @@
 #include "rtp-server.h"
+#include "rtp-pipeline.h"
 #include <cstring>
 #include <unistd.h>
 #include <iostream>
-#include <chrono>
-#include <thread>
-#include <random>
-#include <sstream>
-#include <iomanip>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
 #include <sys/time.h>
 
+// Forwarding limits
+static const size_t kMaxForwardBatch = 1024;        // sendmmsg() accepts at most UIO_MAXIOV messages
+static const double kDefaultForwardRate = 1000000.0; // Bytes per second per subscriber
+static const double kMinForwardRate = 8000.0;
+static const double kForwardBurstSeconds = 0.1;     // Token bucket depth
+static const size_t kMaxStreamName = 32;            // Keeps rewritten headers within Subscriber::header
+static const size_t kSealedSlot = sizeof(Subscriber::header) + kMaxPacketSize + kSrtpMaxOverhead;
+
+// Idle wakeup of the receive loop, for log flushing and stop()
+static const int kReceiveTimeoutUsec = 250000;
+
 std::string RTPServer::getClientKey(const struct sockaddr_in& addr) {
-    std::ostringstream oss;
-    char ipStr[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &(addr.sin_addr), ipStr, INET_ADDRSTRLEN);
-    oss << ipStr << ":" << ntohs(addr.sin_port);
-    return oss.str();
+    // Called for every packet, so format without a stream
+    char key[INET_ADDRSTRLEN + 8];
+    inet_ntop(AF_INET, &(addr.sin_addr), key, INET_ADDRSTRLEN);
+    size_t ipLen = strlen(key);
+    snprintf(key + ipLen, sizeof(key) - ipLen, ":%u", ntohs(addr.sin_port));
+    return key;
 }
 
-RTPServer::RTPServer(int port) : fecEnabled(false), congestionControlEnabled(false) {
+RTPServer::RTPServer(int port)
+    : running(true), nextLogFlushNs(0), fecEnabled(false), congestionControlEnabled(false), loggingEnabled(true),
+      timestampSource(TimestampSource::Monotonic), forwardingEnabled(false),
+      forwardRateLimit(kDefaultForwardRate), nextSsrc(1), totalPackets(0), binaryLogsEnabled(false),
+      srtpEnabled(false), controlSequence(0), controlSsrc(0) {
+    selectPipeline();
+
     sockfd = socket(AF_INET, SOCK_DGRAM, 0);
     if (sockfd < 0) {
         perror("Socket creation failed");
@@ -33,6 +50,15 @@ RTPServer::RTPServer(int port) : fecEnabled(false), congestionControlEnabled(fal
         perror("Bind failed");
         exit(EXIT_FAILURE);
     }
+
+    // Wake up regularly while idle to flush logs and notice stop()
+    struct timeval timeout = {0, kReceiveTimeoutUsec};
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+        perror("Failed to set receive timeout");
+    }
+
+    timestampSource = enableReceiveTimestamps(sockfd);
+    std::cout << "Receive timestamps: " << timestampSourceName(timestampSource) << std::endl;
     
     // Open server log file
     serverLog.open("server_stats.csv");
@@ -55,160 +81,440 @@ RTPServer::~RTPServer() {
     if (serverLog.is_open()) {
         serverLog.close();
     }
+    serverBinaryLog.close();
+    disableCapture();
     
     close(sockfd);
 }
 
+// Every combination of runtime settings, instantiated once: [fec][congestion][logging]
+#define PIPELINE(fec, congestion, log) ServerPipeline<fec, congestion, log, SocketIO>
+static const struct {
+    void (*run)(RTPServer&);
+    void (*send)(RTPServer&, const std::string&, struct sockaddr_in&, socklen_t);
+} kPipelines[2][2][2] = {
+    {{{&PIPELINE(NoFec, NoCongestion, NoLogging)::run, &PIPELINE(NoFec, NoCongestion, NoLogging)::send},
+      {&PIPELINE(NoFec, NoCongestion, FileLogging)::run, &PIPELINE(NoFec, NoCongestion, FileLogging)::send}},
+     {{&PIPELINE(NoFec, SimulatedCongestion, NoLogging)::run, &PIPELINE(NoFec, SimulatedCongestion, NoLogging)::send},
+      {&PIPELINE(NoFec, SimulatedCongestion, FileLogging)::run, &PIPELINE(NoFec, SimulatedCongestion, FileLogging)::send}}},
+    {{{&PIPELINE(RepeatFec, NoCongestion, NoLogging)::run, &PIPELINE(RepeatFec, NoCongestion, NoLogging)::send},
+      {&PIPELINE(RepeatFec, NoCongestion, FileLogging)::run, &PIPELINE(RepeatFec, NoCongestion, FileLogging)::send}},
+     {{&PIPELINE(RepeatFec, SimulatedCongestion, NoLogging)::run, &PIPELINE(RepeatFec, SimulatedCongestion, NoLogging)::send},
+      {&PIPELINE(RepeatFec, SimulatedCongestion, FileLogging)::run, &PIPELINE(RepeatFec, SimulatedCongestion, FileLogging)::send}}}
+};
+#undef PIPELINE
+
+void RTPServer::selectPipeline() {
+    // Simulated congestion sleeps up to 300 ms per packet, which low-latency mode exists to avoid
+    bool congestion = congestionControlEnabled && !lowLatency.enabled;
+    packetHandler = kPipelines[fecEnabled][congestion][loggingEnabled].run;
+    sendHandler = kPipelines[fecEnabled][congestion][loggingEnabled].send;
+}
+
 void RTPServer::receivePacket() {
-    char buffer[1024];
-    memset(buffer, 0, sizeof(buffer));
-    
-    struct sockaddr_in clientAddr;
-    socklen_t clientLen = sizeof(clientAddr);
+    packetHandler(*this);
+}
 
-    int bytesReceived = recvfrom(sockfd, buffer, sizeof(buffer), 0,
-                                (struct sockaddr*)&clientAddr, &clientLen);
-    if (bytesReceived < 0) {
-        perror("Receive failed");
-        return;
+void RTPServer::sendPacket(const std::string& message, struct sockaddr_in& clientAddr, socklen_t clientLen) {
+    sendHandler(*this, message, clientAddr, clientLen);
+}
+
+void FileLogging::onNewClient(RTPServer& server, const std::string& clientKey, ClientData& client) {
+    // Create jitter log file for this client
+    std::string logFilename = "jitter_" + client.clientIP + "_" + std::to_string(client.clientPort);
+    if (server.binaryLogsEnabled) {
+        client.binaryLog.open(logFilename + ".rtplog", kServerJitterSchema);
+    } else {
+        client.jitterLog.open(logFilename + ".csv");
+        client.jitterLog << "timestamp,packet_id,jitter_ms,delay_ms\n";
     }
     
-    // Get unique client identifier and timestamp
-    std::string clientKey = getClientKey(clientAddr);
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    long long timestamp = tv.tv_sec * 1000LL + tv.tv_usec / 1000; // milliseconds
+    if (!client.jitterLog.is_open() && !client.binaryLog.is_open()) {
+        std::cerr << "Failed to open jitter log for client " << clientKey << std::endl;
+    }
     
-    // Simulate jitter with random delay (0-100ms)
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<int> jitterDist(0, 100);
-    int jitter = jitterDist(gen);
+    std::cout << "New client connected: " << clientKey << std::endl;
+}
+
+void FileLogging::onPacket(RTPServer&, const std::string& clientKey, ClientData& client,
+                           const char* buffer, const RTPHeader& header, const ReceiveTime& recvTime,
+                           double delayMs) {
+    long long timestamp = recvTime.ns / 1000000; // milliseconds
+    double jitterMs = client.jitter.jitterMs();
     
     std::cout << "Received from " << clientKey << ": " << buffer 
-              << " (Jitter: " << jitter << "ms)" << std::endl;
-    
-    // Thread-safe access to clients map
-    clientsMutex.lock();
-    
-    // If this is a new client, set up their data
-    if (clients.find(clientKey) == clients.end()) {
-        clients[clientKey] = ClientData();
-        clients[clientKey].addr = clientAddr;
-        clients[clientKey].addrLen = clientLen;
-        
-        // Extract client IP and port for the filename
-        char ipStr[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &(clientAddr.sin_addr), ipStr, INET_ADDRSTRLEN);
-        clients[clientKey].clientIP = ipStr;
-        clients[clientKey].clientPort = ntohs(clientAddr.sin_port);
-        
-        // Create jitter log file for this client
-        std::string logFilename = "jitter_" + clients[clientKey].clientIP + "_" + 
-                                 std::to_string(clients[clientKey].clientPort) + ".csv";
-        clients[clientKey].jitterLog.open(logFilename);
-        
-        if (clients[clientKey].jitterLog.is_open()) {
-            clients[clientKey].jitterLog << "timestamp,packet_id,jitter_ms,delay_ms\n";
-        } else {
-            std::cerr << "Failed to open jitter log for client " << clientKey << std::endl;
-        }
-        
-        std::cout << "New client connected: " << clientKey << std::endl;
-    }
-    
-    ClientData& client = clients[clientKey];
+              << " (Jitter: " << jitterMs << "ms, Delay: " << delayMs << "ms)" << std::endl;
     
     // Log jitter data for this packet
-    if (client.jitterLog.is_open()) {
+    if (client.binaryLog.is_open()) {
+        ServerJitterRecord record;
+        record.timestamp = timestamp;
+        record.packetId = client.packetCounter;
+        record.sequence = header.sequence;
+        record.jitterMs = static_cast<float>(jitterMs);
+        record.delayMs = static_cast<float>(delayMs);
+        client.binaryLog.append(&record);
+    } else if (client.jitterLog.is_open()) {
         client.jitterLog << timestamp << "," 
                         << client.packetCounter << "," 
-                        << jitter << "," 
-                        << jitter + (client.packetCounter % 5 == 0 ? 200 : 0) << "\n";
+                        << jitterMs << "," 
+                        << delayMs << "\n";
         client.jitterLog.flush(); // Ensure data is written immediately
     }
+}
+
+void FileLogging::onStats(RTPServer& server, const ReceiveTime& recvTime) {
+    // Update server stats periodically (every 10 packets)
+    server.totalPackets++;
+    if (server.totalPackets % 10 != 0 || !(server.serverLog.is_open() || server.serverBinaryLog.is_open())) {
+        return;
+    }
     
-    // Store packet for FEC
-    client.packetHistory[client.packetCounter] = buffer;
+    long long timestamp = recvTime.ns / 1000000; // milliseconds
+    double sumJitter = 0.0;
+    int count = 0;
     
-    // Every 4 packets, send an FEC packet
-    if (fecEnabled && client.packetCounter % 4 == 0 && client.packetCounter > 0) {
-        sendPacket("FEC_PACKET: " + client.packetHistory[client.packetCounter - 3], clientAddr, clientLen);
+    server.clientsMutex.lock();
+    for (const auto& client_pair : server.clients) {
+        sumJitter += client_pair.second.jitter.jitterMs();
+        count++;
     }
+    server.clientsMutex.unlock();
     
-    client.packetCounter++;
-    clientsMutex.unlock();
+    double avg_jitter = count > 0 ? sumJitter / count : 0.0;
     
-    // Simulate network jitter
-    std::this_thread::sleep_for(std::chrono::milliseconds(jitter));
-    
-    // Update server stats periodically (every 10 packets)
-    static int totalPackets = 0;
-    totalPackets++;
-    if (totalPackets % 10 == 0 && serverLog.is_open()) {
-        long long sum_jitter = 0;
-        int count = 0;
-        
-        clientsMutex.lock();
-        for (const auto& client_pair : clients) {
-            count++;
-        }
-        clientsMutex.unlock();
-        
-        // Simple calculation - in reality you might want more sophisticated stats
-        int avg_jitter = jitter; // This is simplified, should aggregate from all clients
-        
-        serverLog << timestamp << ","
-                 << count << ","
-                 << totalPackets << ","
-                 << avg_jitter << "\n";
-        serverLog.flush();
+    if (server.serverBinaryLog.is_open()) {
+        ServerStatsRecord record;
+        record.timestamp = timestamp;
+        record.totalClients = count;
+        record.totalPackets = server.totalPackets;
+        record.avgJitterMs = static_cast<float>(avg_jitter);
+        server.serverBinaryLog.append(&record);
+    } else {
+        server.serverLog << timestamp << ","
+                         << count << ","
+                         << server.totalPackets << ","
+                         << avg_jitter << "\n";
+        server.serverLog.flush();
     }
-    
-    // Send acknowledgment
-    sendPacket("Acknowledged", clientAddr, clientLen);
 }
 
-void RTPServer::sendPacket(const std::string& message, struct sockaddr_in& clientAddr, socklen_t clientLen) {
-    std::string clientKey = getClientKey(clientAddr);
-    
-    // Simulate congestion by adding delay if packet rate is too high
-    bool applyCongestionDelay = false;
-    
-    clientsMutex.lock();
-    if (clients.find(clientKey) != clients.end()) {
-        ClientData& client = clients[clientKey];
-        applyCongestionDelay = (congestionControlEnabled && client.packetCounter % 5 == 0);
+void RTPServer::start() {
+    if (lowLatency.enabled) {
+        // Placed here so the thread that runs the receive loop is the one pinned
+        placeCurrentThread(lowLatency.receiveCpu, "Receive thread");
+        enableSpinPolling(sockfd, lowLatency.busyPollUsec);
     }
-    clientsMutex.unlock();
-
-    if (applyCongestionDelay) {
-        std::cout << "Simulated congestion for " << clientKey << "! Introducing delay..." << std::endl;
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));  // 200ms delay
+    std::cout << "RTP Server started. Waiting for packets..." << std::endl;
+    while (running) {
+        receivePacket();
+        flushIdleLogs();
     }
+    std::cout << "RTP Server stopped" << std::endl;
+}
 
-    sendto(sockfd, message.c_str(), message.size(), 0,
-           (struct sockaddr*)&clientAddr, clientLen);
-    std::cout << "Sent to " << clientKey << ": " << message << std::endl;
+void RTPServer::stop() {
+    running = false;
 }
 
-void RTPServer::start() {
-    std::cout << "RTP Server started. Waiting for packets..." << std::endl;
-    while (true) {
-        receivePacket();
+void RTPServer::flushIdleLogs() {
+    int64_t now = monotonicWallNs();
+    if (now < nextLogFlushNs) {
+        return;
+    }
+    nextLogFlushNs = now + BinaryLogWriter::kFlushIntervalMs * 1000000;
+
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    for (auto& client : clients) {
+        client.second.binaryLog.flushIfDue();
     }
+    serverBinaryLog.flushIfDue();
 }
 
 void RTPServer::enableFEC(bool enable) {
     fecEnabled = enable;
+    selectPipeline();
     std::cout << "FEC " << (enable ? "enabled" : "disabled") << std::endl;
 }
 
 void RTPServer::enableCongestionControl(bool enable) {
     congestionControlEnabled = enable;
+    selectPipeline();
     std::cout << "Congestion Control " << (enable ? "enabled" : "disabled") << std::endl;
 }
 
+void RTPServer::enableLowLatency(const LowLatencyConfig& config) {
+    lowLatency = config;
+    selectPipeline();
+    std::cout << "Low-latency mode " << (config.enabled ? "enabled" : "disabled") << std::endl;
+    if (config.enabled && congestionControlEnabled) {
+        std::cout << "Simulated congestion delays are skipped in low-latency mode" << std::endl;
+    }
+}
+
+void RTPServer::enableLogging(bool enable) {
+    loggingEnabled = enable;
+    selectPipeline();
+    std::cout << "Logging " << (enable ? "enabled" : "disabled") << std::endl;
+}
+
+void RTPServer::enableBinaryLogs(bool enable) {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    binaryLogsEnabled = enable;
+    if (enable) {
+        // Replace the CSV opened by the constructor; per-client logs follow on connect
+        if (serverLog.is_open()) {
+            serverLog.close();
+            std::remove("server_stats.csv");
+        }
+        if (!serverBinaryLog.open("server_stats.rtplog", kServerStatsSchema)) {
+            std::cerr << "Failed to open server log file" << std::endl;
+        }
+    } else {
+        serverBinaryLog.close();
+        if (!serverLog.is_open()) {
+            serverLog.open("server_stats.csv");
+            serverLog << "timestamp,total_clients,total_packets,avg_jitter_ms\n";
+        }
+    }
+    std::cout << "Binary logs " << (enable ? "enabled" : "disabled") << std::endl;
+}
+
+bool RTPServer::enableCapture(const std::string& traceFile) {
+    if (!capture.open(traceFile)) {
+        std::cerr << "Failed to open packet trace " << traceFile << std::endl;
+        return false;
+    }
+    std::cout << "Capturing packets to " << traceFile << std::endl;
+    return true;
+}
+
+void RTPServer::disableCapture() {
+    if (capture.is_open()) {
+        std::cout << "Captured " << capture.recordCount() << " packets" << std::endl;
+        capture.close();
+    }
+}
+
+bool RTPServer::enableSrtp(SrtpProfile profile, const std::string& keyHex) {
+    if (!srtpIn.init(profile, keyHex) || !srtpOut.init(profile, keyHex)) {
+        return false;
+    }
+    srtpEnabled = true;
+    controlSsrc = newSrtpSsrc();
+    std::cout << "SRTP enabled (" << srtpProfileName(profile) << ")" << std::endl;
+    return true;
+}
+
+void RTPServer::capturePacket(const ReceiveTime& recvTime, const struct sockaddr_in& clientAddr, int size,
+                              bool parsed, const RTPHeader& header, const char* payload, size_t payloadLen) {
+    TraceRecord record;
+    memset(&record, 0, sizeof(record));
+    record.arrivalNs = recvTime.ns;
+    record.srcAddr = clientAddr.sin_addr.s_addr;
+    record.srcPort = clientAddr.sin_port;
+    record.size = static_cast<uint16_t>(size);
+    if (parsed) {
+        record.flags = kTraceHasHeader;
+        record.sequence = header.sequence;
+        record.sendTimeNs = header.sendTimeNs;
+        strncpy(record.source, header.source.c_str(), sizeof(record.source) - 1);
+    }
+    record.payloadLen = static_cast<uint16_t>(payloadLen);
+    record.capturedLen = static_cast<uint16_t>(std::min(payloadLen, kTracePayloadBytes));
+    memcpy(record.payload, payload, record.capturedLen);
+    capture.append(record);
+}
+
+void RTPServer::enableForwarding(bool enable) {
+    forwardingEnabled = enable;
+    std::cout << "Forwarding " << (enable ? "enabled" : "disabled") << std::endl;
+}
+
+void RTPServer::setForwardRateLimit(double bytesPerSec) {
+    forwardRateLimit = std::max(bytesPerSec, kMinForwardRate);
+    std::cout << "Forward rate cap: " << forwardRateLimit << " bytes/s per subscriber" << std::endl;
+}
+
+bool RTPServer::handleSubscription(const char* payload, size_t payloadLen, struct sockaddr_in& clientAddr) {
+    std::string command(payload, std::min(payloadLen, sizeof("UNSUBSCRIBE ") - 1));
+    bool subscribe = command.compare(0, 10, "SUBSCRIBE ") == 0;
+    bool unsubscribe = command == "UNSUBSCRIBE ";
+    if (!subscribe && !unsubscribe) {
+        return false;
+    }
+
+    size_t prefixLen = subscribe ? 10 : 12;
+    std::string streamName(payload + prefixLen, payloadLen - prefixLen);
+    if (streamName.empty()) {
+        return true;
+    }
+    std::string clientKey = getClientKey(clientAddr);
+    if (streamName.size() > kMaxStreamName) {
+        sendPacket("SUBSCRIBE rejected: stream names are limited to " + std::to_string(kMaxStreamName) + " bytes",
+                   clientAddr, sizeof(clientAddr));
+        return true;
+    }
+    std::string reply;
+
+    streamsMutex.lock();
+    auto found = streams.find(streamName);
+    if (found == streams.end()) {
+        if (unsubscribe) {
+            streamsMutex.unlock();
+            return true;
+        }
+        found = streams.insert(std::make_pair(streamName, ForwardStream())).first;
+    }
+    ForwardStream& stream = found->second;
+    auto existing = std::find_if(stream.subscribers.begin(), stream.subscribers.end(),
+                                 [&clientKey](const Subscriber& sub) { return sub.clientKey == clientKey; });
+    if (subscribe && existing == stream.subscribers.end()) {
+        Subscriber sub;
+        sub.addr = clientAddr;
+        sub.clientKey = clientKey;
+        sub.ssrc = streamName + "#" + std::to_string(nextSsrc++);
+        sub.srtpSsrc = srtpEnabled ? newSrtpSsrc() : 0;
+        sub.tokens = forwardRateLimit * kForwardBurstSeconds;
+        sub.lastRefillNs = monotonicWallNs();
+        stream.subscribers.push_back(sub);
+        reply = "SUBSCRIBED " + streamName + " as " + sub.ssrc;
+    } else if (unsubscribe && existing != stream.subscribers.end()) {
+        stream.subscribers.erase(existing);
+        reply = "UNSUBSCRIBED " + streamName;
+    }
+
+    // Size the reusable batch once per membership change, not per packet
+    size_t batch = std::min(stream.subscribers.size(), kMaxForwardBatch);
+    stream.msgs.resize(batch);
+    stream.iovs.resize(batch * 2);
+    stream.batchIndex.resize(batch);
+    size_t subscriberCount = stream.subscribers.size();
+    streamsMutex.unlock();
+
+    if (!reply.empty()) {
+        std::cout << clientKey << ": " << reply << " (" << subscriberCount << " subscribers)" << std::endl;
+        sendPacket(reply, clientAddr, sizeof(clientAddr));
+    }
+    return true;
+}
+
+void RTPServer::forwardPacket(const RTPHeader& header, const char* payload, size_t payloadLen) {
+    std::lock_guard<std::mutex> lock(streamsMutex);
+    auto it = streams.find(header.source);
+    if (it == streams.end() || it->second.subscribers.empty()) {
+        return;
+    }
+
+    ForwardStream& stream = it->second;
+    std::vector<Subscriber>& subscribers = stream.subscribers;
+    int64_t now = monotonicWallNs();
+    size_t count = 0;
+    if (srtpEnabled && stream.sealedPackets.size() < stream.msgs.size()) {
+        stream.sealed.resize(stream.msgs.size() * kSealedSlot);
+        stream.sealedPackets.resize(stream.msgs.size());
+    }
+
+    // Sends the queued batch. A full socket buffer is shared by every
+    // subscriber, so it only drops the message it failed on; it says nothing
+    // about that subscriber's own path.
+    auto flush = [&]() {
+        if (srtpEnabled) {
+            // Seal the whole batch in one call, dropping anything that failed
+            srtpOut.protect(&stream.sealedPackets[0], count);
+            size_t kept = 0;
+            for (size_t k = 0; k < count; k++) {
+                if (!stream.sealedPackets[k].ok) {
+                    Subscriber& sub = subscribers[stream.batchIndex[k]];
+                    sub.sequence++; // Never reuse an index that may have been used
+                    sub.dropped++;
+                    continue;
+                }
+                stream.msgs[k].msg_hdr.msg_iov->iov_len = stream.sealedPackets[k].length;
+                stream.msgs[kept] = stream.msgs[k];
+                stream.batchIndex[kept] = stream.batchIndex[k];
+                kept++;
+            }
+            count = kept;
+        }
+        size_t sent = 0;
+        while (sent < count) {
+            int n = sendmmsg(sockfd, &stream.msgs[sent], count - sent, MSG_DONTWAIT);
+            if (n < 0) {
+                Subscriber& sub = subscribers[stream.batchIndex[sent]];
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+                    perror("Forward failed");
+                }
+                if (srtpEnabled) {
+                    sub.sequence++; // Its index already sealed a packet and must not be reused
+                }
+                sub.dropped++;
+                sent++;
+                continue;
+            }
+            for (size_t k = sent; k < sent + n; k++) {
+                Subscriber& sub = subscribers[stream.batchIndex[k]];
+                sub.sequence++;
+                sub.forwarded++;
+                sub.tokens -= stream.msgs[k].msg_len;
+            }
+            sent += n;
+        }
+        count = 0;
+    };
+
+    for (size_t i = 0; i < subscribers.size(); i++) {
+        Subscriber& sub = subscribers[i];
+
+        // Refill the token bucket and drop this packet if the subscriber is over the rate cap
+        double elapsed = (now - sub.lastRefillNs) / 1e9;
+        sub.lastRefillNs = now;
+        sub.tokens = std::min(forwardRateLimit * kForwardBurstSeconds,
+                              sub.tokens + elapsed * forwardRateLimit);
+        if (sub.tokens < static_cast<double>(payloadLen)) {
+            sub.dropped++;
+            continue;
+        }
+
+        // Rewrite SSRC and sequence; the payload is shared by every message
+        size_t headerLen = formatHeader(sub.ssrc.c_str(), sub.sequence, header.sendTimeNs, sub.srtpSsrc,
+                                        sub.header, sizeof(sub.header));
+        struct iovec* iov = &stream.iovs[count * 2];
+        iov[0].iov_base = sub.header;
+        iov[0].iov_len = headerLen;
+        iov[1].iov_base = const_cast<char*>(payload);
+        iov[1].iov_len = payloadLen;
+
+        struct msghdr& msg = stream.msgs[count].msg_hdr;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &sub.addr;
+        msg.msg_namelen = sizeof(sub.addr);
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 2;
+
+        // Each subscriber's copy is encrypted under its own SSRC, so the payload cannot be shared
+        if (srtpEnabled) {
+            char* slot = &stream.sealed[count * kSealedSlot];
+            memcpy(slot, sub.header, headerLen);
+            memcpy(slot + headerLen, payload, payloadLen);
+            SrtpPacket& sealed = stream.sealedPackets[count];
+            sealed.data = slot;
+            sealed.headerLen = headerLen;
+            sealed.length = headerLen + payloadLen;
+            sealed.ssrc = sub.srtpSsrc;
+            sealed.index = static_cast<uint32_t>(sub.sequence);
+            iov[0].iov_base = slot;
+            msg.msg_iovlen = 1;
+        }
+        stream.batchIndex[count] = i;
+
+        if (++count == stream.msgs.size()) {
+            flush();
+        }
+    }
+    flush();
+}
+
 void RTPServer::manageCongestion(ClientData& client) {
     // Implement more sophisticated congestion control if needed
     // This is a placeholder for a more complex algorithm
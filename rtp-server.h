@@ -4,11 +4,19 @@
 #include <iostream>
 #include <string>
 #include <arpa/inet.h>
+#include <sys/socket.h>
 #include <vector>
 #include <queue>
 #include <map>
 #include <fstream>
 #include <mutex>
+#include <atomic>
+#include "rtp-timestamp.h"
+#include "rtp-packet.h"
+#include "rtp-log.h"
+#include "rtp-trace.h"
+#include "rtp-lowlatency.h"
+#include "rtp-srtp.h"
 
 struct ClientData {
     struct sockaddr_in addr;
@@ -17,38 +25,119 @@ struct ClientData {
     std::map<int, std::string> packetHistory;
     int packetCounter;
     std::ofstream jitterLog;
+    BinaryLogWriter binaryLog; // Used instead of jitterLog when binary logs are enabled
     std::string clientIP;
     int clientPort;
+    JitterEstimator jitter; // RFC 3550 interarrival jitter from receive timestamps
+    int sendSequence; // Sequence number for packets sent back to this client
+    uint64_t srtpSsrc; // Random SSRC of the stream back to this client, 0 until SRTP first uses it
     
-    ClientData() : packetCounter(0) {}
+    ClientData() : packetCounter(0), sendSequence(0), srtpSsrc(0) {}
 };
 
+// A receiver of a forwarded stream, with its own header rewriting and rate cap
+struct Subscriber {
+    struct sockaddr_in addr;
+    std::string clientKey;
+    std::string ssrc;      // Source name rewritten into forwarded headers
+    int sequence;          // Next rewritten sequence number, contiguous despite drops
+    char header[96];       // Scratch space for this subscriber's rewritten header
+    uint64_t srtpSsrc;     // Random SRTP SSRC of this forwarded copy
+    double tokens;         // Token bucket that drops packets above the forwarding rate limit
+    int64_t lastRefillNs;
+    long long forwarded;
+    long long dropped;
+
+    Subscriber() : sequence(0), srtpSsrc(0), tokens(0.0), lastRefillNs(0),
+                   forwarded(0), dropped(0) {}
+};
+
+// An incoming stream (keyed by its SSRC) and everyone subscribed to it
+struct ForwardStream {
+    std::vector<Subscriber> subscribers;
+    std::vector<struct mmsghdr> msgs;   // Reused sendmmsg batch, one entry per subscriber
+    std::vector<struct iovec> iovs;     // Header + shared payload iovec per subscriber
+    std::vector<size_t> batchIndex;     // Subscriber index of each message in the batch
+    std::vector<char> sealed;           // With SRTP, a header + payload copy per message, sealed in place
+    std::vector<SrtpPacket> sealedPackets;
+};
+
+template <class Fec, class Congestion, class Log, class Io> struct ServerPipeline;
+struct FileLogging;
+
 class RTPServer {
 public:
     RTPServer(int port);
     ~RTPServer();
 
-    void start(); // Starts the server
+    void start(); // Starts the server; returns after stop()
+    void stop(); // Makes start() return so the destructor closes the logs (safe in a signal handler)
     void sendPacket(const std::string& message, struct sockaddr_in& clientAddr, socklen_t clientLen); // Sends an RTP packet
     void enableFEC(bool enable); // Enables Forward Error Correction
     void enableCongestionControl(bool enable); // Enables Congestion Control
+    void enableForwarding(bool enable); // Enables SFU fan-out of each stream to its subscribers
+    void setForwardRateLimit(double bytesPerSec); // Fixed per-subscriber rate cap (not congestion control)
+    void enableBinaryLogs(bool enable); // Writes .rtplog columnar logs instead of CSV
+    void enableLogging(bool enable); // Console output, jitter logs and server stats
+    void enableLowLatency(const LowLatencyConfig& config); // Pinned, spin-polling receive loop (applied by start())
+    bool enableCapture(const std::string& traceFile); // Records every arrival to a trace for rtp-replay
+    bool enableSrtp(SrtpProfile profile, const std::string& keyHex); // Encrypts and authenticates all traffic
+    void disableCapture();
 
 private:
+    template <class Fec, class Congestion, class Log, class Io> friend struct ServerPipeline;
+    friend struct FileLogging;
+
+    // Pre-instantiated pipeline for the current settings, see rtp-pipeline.h
+    typedef void (*PacketHandler)(RTPServer& server);
+    typedef void (*SendHandler)(RTPServer& server, const std::string& message,
+                                struct sockaddr_in& clientAddr, socklen_t clientLen);
+    PacketHandler packetHandler;
+    SendHandler sendHandler;
+
     int sockfd;
     struct sockaddr_in serverAddr;
+    std::atomic<bool> running;
+    int64_t nextLogFlushNs; // When start() next flushes idle binary logs
     
     bool fecEnabled;
     bool congestionControlEnabled;
+    bool loggingEnabled;
+    TimestampSource timestampSource; // Best receive timestamp source enabled on sockfd
+    bool forwardingEnabled;
+    double forwardRateLimit;
+    int nextSsrc; // Counter used to give each subscription a unique outgoing SSRC
     
     std::map<std::string, ClientData> clients; // Map to store client data using IP:port as key
     std::mutex clientsMutex; // Mutex for thread-safe access to clients map
     
+    std::map<std::string, ForwardStream> streams; // Forwarded streams keyed by source SSRC
+    std::mutex streamsMutex; // Mutex for thread-safe access to streams map
+    
     std::ofstream serverLog; // File to log server-side statistics
+    long long totalPackets; // Packets handled by the pipeline, for server stats
+    BinaryLogWriter serverBinaryLog; // Binary counterpart of serverLog
+    bool binaryLogsEnabled;
+    
+    TraceWriter capture; // Packet trace, open while capture is enabled
+    LowLatencyConfig lowLatency;
+    
+    bool srtpEnabled;
+    SrtpContext srtpIn;  // Unprotects arrivals, holds the per-SSRC replay windows
+    SrtpContext srtpOut; // Protects acks, FEC, control replies and forwarded packets
+    int controlSequence; // Sequence for replies to addresses that are not clients (SFU subscribers)
+    uint64_t controlSsrc; // Random SRTP SSRC of those replies
     
     void receivePacket();
+    void flushIdleLogs(); // Writes binary log records that have waited for kFlushIntervalMs
+    void selectPipeline(); // Picks packetHandler/sendHandler from the dispatch table
     void applyFEC(std::string& message); // FEC error correction method
     void manageCongestion(ClientData& client); // Congestion control logic
     std::string getClientKey(const struct sockaddr_in& addr); // Get unique key for client
+    bool handleSubscription(const char* payload, size_t payloadLen, struct sockaddr_in& clientAddr); // SUBSCRIBE/UNSUBSCRIBE control
+    void capturePacket(const ReceiveTime& recvTime, const struct sockaddr_in& clientAddr, int size, bool parsed,
+                       const RTPHeader& header, const char* payload, size_t payloadLen); // Appends one arrival to the trace
+    void forwardPacket(const RTPHeader& header, const char* payload, size_t payloadLen); // Fans one packet out to all subscribers
 };
 
 #endif // RTP_SERVER_H
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "rtp-pipeline.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/resource.h>
+
+// Measures SFU fan-out cost on one core: one publisher stream forwarded to N
+// subscribers through the real forwarding path (header rewrite, rate cap,
+// batched sendmmsg). Subscribers are loopback sockets nobody reads, so the
+// kernel drops once their buffers fill; the sender does the full work either way.
+//
+// Usage: rtp-sfu-bench [subscribers] [packets] [payload-bytes] [stream-packets/s]
+
+// Feeds a fixed list of datagrams into the pipeline; sends go to the real socket
+struct ScriptIO {
+    std::vector<std::string> packets;
+    std::vector<struct sockaddr_in> sources;
+    size_t next;
+
+    explicit ScriptIO(int) : next(0) {}
+
+    int receive(char* buffer, size_t len, struct sockaddr_in* addr, socklen_t* addrLen, ReceiveTime& recvTime) {
+        const std::string& packet = packets[next];
+        size_t size = std::min(len, packet.size());
+        memcpy(buffer, packet.data(), size);
+        *addr = sources[next];
+        *addrLen = sizeof(*addr);
+        recvTime.ns = monotonicWallNs();
+        recvTime.source = TimestampSource::Monotonic;
+        next++;
+        return static_cast<int>(size);
+    }
+
+    void send(const std::string&, const struct sockaddr_in&, socklen_t) {}
+    void delay(int) {}
+};
+
+typedef ServerPipeline<NoFec, NoCongestion, NoLogging, ScriptIO> BenchPipeline;
+
+static struct sockaddr_in bindLoopback(int fd) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        getsockname(fd, (struct sockaddr*)&addr, &addrLen) < 0) {
+        perror("Bind failed");
+        exit(EXIT_FAILURE);
+    }
+    return addr;
+}
+
+int main(int argc, char* argv[]) {
+    size_t subscriberCount = argc > 1 ? std::stoul(argv[1]) : 1000;
+    size_t count = argc > 2 ? std::stoul(argv[2]) : 2000;
+    size_t payloadSize = argc > 3 ? std::stoul(argv[3]) : 1200;
+    double streamRate = argc > 4 ? std::stod(argv[4]) : 50.0;
+    if (subscriberCount == 0 || count == 0 || payloadSize + 64 > kMaxPacketSize) {
+        std::cerr << "Need at least one subscriber and packet, and payloads under "
+                  << kMaxPacketSize - 64 << " bytes" << std::endl;
+        return 1;
+    }
+
+    // The server writes its stats log into the current directory
+    char scratch[] = "/tmp/rtp-sfu-bench-XXXXXX";
+    if (mkdtemp(scratch) == NULL || chdir(scratch) != 0) {
+        perror("Failed to create scratch directory");
+        return 1;
+    }
+
+    // One socket per subscriber
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < subscriberCount + 64) {
+        limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, subscriberCount + 64);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    std::vector<int> sockets;
+    ScriptIO io(0);
+    for (size_t i = 0; i < subscriberCount; i++) {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            perror("Too many subscribers for the file descriptor limit");
+            return 1;
+        }
+        sockets.push_back(fd);
+        RTPHeader header;
+        header.source = "sub_" + std::to_string(i);
+        io.packets.push_back(buildPacket(header, "SUBSCRIBE pub"));
+        io.sources.push_back(bindLoopback(fd));
+    }
+    int publisher = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in publisherAddr = bindLoopback(publisher);
+    std::string payload(payloadSize, 'v');
+    for (size_t i = 0; i < count; i++) {
+        RTPHeader header;
+        header.source = "pub";
+        header.sequence = static_cast<int>(i);
+        header.sendTimeNs = wallClockNs();
+        io.packets.push_back(buildPacket(header, payload));
+        io.sources.push_back(publisherAddr);
+    }
+
+    // Subscription replies are printed, keep them out of the results
+    std::ofstream devNull("/dev/null");
+    std::streambuf* original = std::cout.rdbuf(devNull.rdbuf());
+    RTPServer server(0);
+    server.enableLogging(false);
+    server.enableForwarding(true);
+    server.setForwardRateLimit(1e12); // Measure fan-out, not the rate cap
+    for (size_t i = 0; i < subscriberCount; i++) {
+        BenchPipeline::receivePacket(server, io);
+    }
+    std::cout.rdbuf(original);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        BenchPipeline::receivePacket(server, io);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double totalNs = std::chrono::duration<double, std::nano>(end - start).count();
+    double nsPerCopy = totalNs / (count * subscriberCount);
+    std::cout << "SFU fan-out: " << count << " packets of " << payloadSize << " bytes to "
+              << subscriberCount << " subscribers" << std::endl;
+    std::cout << "  " << totalNs / count / 1000.0 << " us per incoming packet, " << nsPerCopy
+              << " ns per forwarded copy (" << 1e9 / nsPerCopy << " copies/s)" << std::endl;
+    std::cout << "  One core sustains ~" << static_cast<long long>(1e9 / nsPerCopy / streamRate)
+              << " subscribers of a " << streamRate << " packets/s stream" << std::endl;
+
+    for (int fd : sockets) {
+        close(fd);
+    }
+    close(publisher);
+    return 0;
+}
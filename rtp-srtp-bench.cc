@@ -0,0 +1,193 @@
+#include "rtp-srtp.h"
+#include "rtp-timestamp.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+// Measures SRTP cost at 1200-byte payloads. First the crypto alone, per
+// packet and in batches, then the send path (build, protect, sendmmsg over
+// loopback) against plaintext, as the median of interleaved runs so that
+// loopback noise affects every mode alike. The key is random for every run.
+//
+// Usage: rtp-srtp-bench [packets] [batch]
+
+static const size_t kPayloadSize = 1200;
+static const int kSendRuns = 7; // Send-path runs per mode, interleaved; the median is reported
+
+struct PacketBatch {
+    std::vector<char> storage;
+    std::vector<SrtpPacket> packets;
+    size_t slot;
+
+    uint64_t ssrc;
+
+    PacketBatch(size_t count)
+        : storage(count * kMaxPacketSize), packets(count), slot(kMaxPacketSize), ssrc(newSrtpSsrc()) {}
+
+    // Writes a fresh header + payload into every slot, as the send path would
+    void fill(uint64_t firstIndex) {
+        for (size_t i = 0; i < packets.size(); i++) {
+            char* data = &storage[i * slot];
+            int sequence = static_cast<int>(firstIndex + i);
+            size_t headerLen = formatHeader("client_1", sequence, wallClockNs(), ssrc, data, slot);
+            memset(data + headerLen, 'p', kPayloadSize);
+            packets[i].data = data;
+            packets[i].headerLen = headerLen;
+            packets[i].length = headerLen + kPayloadSize;
+            packets[i].ssrc = ssrc;
+            packets[i].index = static_cast<uint32_t>(sequence);
+        }
+    }
+};
+
+static std::string randomKey(size_t bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string key;
+    unsigned int seed = static_cast<unsigned int>(wallClockNs());
+    for (size_t i = 0; i < bytes * 2; i++) {
+        key += digits[rand_r(&seed) & 15];
+    }
+    return key;
+}
+
+static std::string keyFor(SrtpProfile profile) {
+    return randomKey(profile == SrtpProfile::AeadAes128Gcm ? 28 : 30);
+}
+
+// Protect + unprotect, calling the context once per batch of size batch
+static void benchmarkCrypto(SrtpProfile profile, size_t count, size_t batch) {
+    std::string key = keyFor(profile);
+    SrtpContext sender, receiver;
+    sender.init(profile, key);
+    receiver.init(profile, key);
+    PacketBatch packets(batch);
+
+    double protectNs = 0.0;
+    double unprotectNs = 0.0;
+    size_t failed = 0;
+    for (size_t done = 0; done < count; done += batch) {
+        packets.fill(done + 1);
+        auto start = std::chrono::steady_clock::now();
+        sender.protect(&packets.packets[0], batch);
+        auto mid = std::chrono::steady_clock::now();
+        failed += batch - receiver.unprotect(&packets.packets[0], batch);
+        auto end = std::chrono::steady_clock::now();
+        protectNs += std::chrono::duration<double, std::nano>(mid - start).count();
+        unprotectNs += std::chrono::duration<double, std::nano>(end - mid).count();
+    }
+
+    size_t rounded = (count + batch - 1) / batch * batch;
+    double protectPerPacket = protectNs / rounded;
+    double unprotectPerPacket = unprotectNs / rounded;
+    std::cout << "  " << srtpProfileName(profile) << ", batch " << batch << ": protect "
+              << protectPerPacket << " ns/packet (" << kPayloadSize * 8 / protectPerPacket << " Gbit/s), unprotect "
+              << unprotectPerPacket << " ns/packet (" << kPayloadSize * 8 / unprotectPerPacket << " Gbit/s)";
+    if (failed > 0) {
+        std::cout << ", " << failed << " FAILED";
+    }
+    std::cout << std::endl;
+}
+
+// Build, optionally protect, and sendmmsg count packets to a loopback socket
+static double benchmarkSend(SrtpContext* srtp, size_t count, size_t batch) {
+    int receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    int sender = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    if (bind(receiver, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        getsockname(receiver, (struct sockaddr*)&addr, &addrLen) < 0) {
+        perror("Bind failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Nobody reads: once the receive buffer is full the kernel drops, the same for every mode
+    PacketBatch packets(batch);
+    std::vector<struct mmsghdr> msgs(batch);
+    std::vector<struct iovec> iovs(batch);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t done = 0; done < count; done += batch) {
+        packets.fill(done + 1);
+        if (srtp != NULL) {
+            srtp->protect(&packets.packets[0], batch);
+        }
+        for (size_t i = 0; i < batch; i++) {
+            iovs[i].iov_base = packets.packets[i].data;
+            iovs[i].iov_len = packets.packets[i].length;
+            memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+            msgs[i].msg_hdr.msg_name = &addr;
+            msgs[i].msg_hdr.msg_namelen = sizeof(addr);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        size_t sent = 0;
+        while (sent < batch) {
+            int n = sendmmsg(sender, &msgs[sent], batch - sent, 0);
+            if (n < 0) {
+                perror("Send failed");
+                exit(EXIT_FAILURE);
+            }
+            sent += n;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    close(sender);
+    close(receiver);
+    size_t rounded = (count + batch - 1) / batch * batch;
+    return rounded / std::chrono::duration<double>(end - start).count();
+}
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 200000;
+    size_t batch = argc > 2 ? std::stoul(argv[2]) : 32;
+    if (batch == 0) {
+        batch = 1;
+    }
+
+    std::cout << "SRTP benchmark: " << count << " packets, " << kPayloadSize << "-byte payloads" << std::endl;
+    std::cout << "Crypto only:" << std::endl;
+    const SrtpProfile profiles[] = {SrtpProfile::AeadAes128Gcm, SrtpProfile::AesCm128HmacSha1_80};
+    for (SrtpProfile profile : profiles) {
+        benchmarkCrypto(profile, count, 1);
+        benchmarkCrypto(profile, count, batch);
+    }
+
+    std::cout << "Send path (build + protect + sendmmsg over loopback, batch " << batch
+              << ", median of " << kSendRuns << " runs):" << std::endl;
+    benchmarkSend(NULL, count / 10, batch); // Warm up
+    std::vector<double> plaintextRuns;
+    std::vector<std::vector<double>> encryptedRuns(2);
+    for (int run = 0; run < kSendRuns; run++) {
+        plaintextRuns.push_back(benchmarkSend(NULL, count, batch));
+        for (size_t p = 0; p < 2; p++) {
+            SrtpContext srtp;
+            srtp.init(profiles[p], keyFor(profiles[p]));
+            encryptedRuns[p].push_back(benchmarkSend(&srtp, count, batch));
+        }
+    }
+    double plaintext = median(plaintextRuns);
+    std::cout << "  plaintext: " << plaintext << " packets/s ("
+              << plaintext * kPayloadSize * 8 / 1e9 << " Gbit/s of payload)" << std::endl;
+    for (size_t p = 0; p < 2; p++) {
+        double encrypted = median(encryptedRuns[p]);
+        std::cout << "  " << srtpProfileName(profiles[p]) << ": " << encrypted << " packets/s, "
+                  << 100.0 * encrypted / plaintext << "% of plaintext" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,357 @@
+#include "rtp-srtp.h"
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <arpa/inet.h>
+#include <iostream>
+#include <openssl/evp.h>
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+
+static const size_t kMasterKeyLen = 16;
+static const size_t kGcmSaltLen = 12;
+static const size_t kCmSaltLen = 14;
+static const size_t kAuthKeyLen = 20;
+static const size_t kGcmTagLen = 16;
+static const size_t kCmTagLen = 10;
+
+// RFC 3711 key derivation labels
+static const unsigned char kLabelEncryption = 0x00;
+static const unsigned char kLabelAuth = 0x01;
+static const unsigned char kLabelSalt = 0x02;
+
+static bool parseHex(const std::string& hex, unsigned char* out, size_t len) {
+    if (hex.size() != len * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        unsigned int byte;
+        if (sscanf(hex.c_str() + i * 2, "%2x", &byte) != 1) {
+            return false;
+        }
+        out[i] = static_cast<unsigned char>(byte);
+    }
+    return true;
+}
+
+// AES-CM PRF: keystream of the master key over (label XOR salt) * 2^16
+static bool deriveSessionKey(const unsigned char* masterKey, const unsigned char* masterSalt,
+                             unsigned char label, unsigned char* out, size_t len) {
+    unsigned char iv[16];
+    memset(iv, 0, sizeof(iv));
+    memcpy(iv, masterSalt, kCmSaltLen);
+    iv[7] ^= label;
+
+    unsigned char zeros[32];
+    memset(zeros, 0, sizeof(zeros));
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    int outLen = 0;
+    bool ok = ctx != NULL &&
+              EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), NULL, masterKey, iv) == 1 &&
+              EVP_EncryptUpdate(ctx, out, &outLen, zeros, static_cast<int>(len)) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    return ok;
+}
+
+static void putUint48(unsigned char* out, uint64_t value) {
+    for (int i = 5; i >= 0; i--) {
+        out[i] ^= static_cast<unsigned char>(value);
+        value >>= 8;
+    }
+}
+
+bool ReplayWindow::check(uint64_t index) const {
+    if (!started || index > highest) {
+        return true;
+    }
+    uint64_t age = highest - index;
+    return age < 64 && !(seen & (1ULL << age));
+}
+
+void ReplayWindow::update(uint64_t index) {
+    if (!started) {
+        started = true;
+        highest = index;
+        seen = 1;
+    } else if (index > highest) {
+        uint64_t shift = index - highest;
+        seen = shift < 64 ? (seen << shift) | 1 : 1;
+        highest = index;
+    } else {
+        seen |= 1ULL << (highest - index);
+    }
+}
+
+SrtpContext::SrtpContext()
+    : activeProfile(SrtpProfile::AeadAes128Gcm), cipher(NULL), mac(NULL),
+      replayedPackets(0), rejectedPackets(0) {
+    memset(sessionSalt, 0, sizeof(sessionSalt));
+}
+
+SrtpContext::~SrtpContext() {
+    EVP_CIPHER_CTX_free(cipher);
+    EVP_MAC_CTX_free(mac);
+}
+
+bool SrtpContext::init(SrtpProfile profile, const std::string& keyHex) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool gcm = profile == SrtpProfile::AeadAes128Gcm;
+    size_t saltLen = gcm ? kGcmSaltLen : kCmSaltLen;
+
+    unsigned char master[kMasterKeyLen + kCmSaltLen];
+    memset(master, 0, sizeof(master));
+    if (!parseHex(keyHex, master, kMasterKeyLen + saltLen)) {
+        std::cerr << "SRTP key must be " << (kMasterKeyLen + saltLen) * 2 << " hex digits (master key + salt) for "
+                  << srtpProfileName(profile) << std::endl;
+        return false;
+    }
+    const unsigned char* masterSalt = master + kMasterKeyLen; // A GCM salt is zero-padded to 14 bytes
+
+    unsigned char encryptionKey[kMasterKeyLen];
+    unsigned char authKey[kAuthKeyLen];
+    memset(sessionSalt, 0, sizeof(sessionSalt));
+    bool ok = deriveSessionKey(master, masterSalt, kLabelEncryption, encryptionKey, sizeof(encryptionKey)) &&
+              deriveSessionKey(master, masterSalt, kLabelSalt, sessionSalt, saltLen) &&
+              (gcm || deriveSessionKey(master, masterSalt, kLabelAuth, authKey, sizeof(authKey)));
+
+    EVP_CIPHER_CTX_free(cipher);
+    EVP_MAC_CTX_free(mac);
+    cipher = EVP_CIPHER_CTX_new();
+    mac = NULL;
+    ok = ok && cipher != NULL &&
+         EVP_CipherInit_ex(cipher, gcm ? EVP_aes_128_gcm() : EVP_aes_128_ctr(), NULL, encryptionKey, NULL, 1) == 1;
+
+    if (ok && !gcm) {
+        EVP_MAC* hmac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+        mac = hmac != NULL ? EVP_MAC_CTX_new(hmac) : NULL;
+        EVP_MAC_free(hmac);
+        OSSL_PARAM params[] = {
+            OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA1"), 0),
+            OSSL_PARAM_construct_end()
+        };
+        ok = mac != NULL && EVP_MAC_init(mac, authKey, sizeof(authKey), params) == 1;
+    }
+    OPENSSL_cleanse(master, sizeof(master));
+    OPENSSL_cleanse(encryptionKey, sizeof(encryptionKey));
+    OPENSSL_cleanse(authKey, sizeof(authKey));
+
+    if (!ok) {
+        std::cerr << "SRTP crypto setup failed" << std::endl;
+        EVP_CIPHER_CTX_free(cipher);
+        EVP_MAC_CTX_free(mac);
+        cipher = NULL;
+        mac = NULL;
+        return false;
+    }
+    activeProfile = profile;
+    replay.clear();
+    return true;
+}
+
+size_t SrtpContext::overhead() const {
+    return activeProfile == SrtpProfile::AeadAes128Gcm ? kGcmTagLen : kCmTagLen;
+}
+
+// GCM: salt XOR (ssrc || index), 12 bytes. AES-CM: (salt XOR (ssrc || index)) * 2^16, 16 bytes.
+void SrtpContext::makeIv(const SrtpPacket& packet, unsigned char* iv) const {
+    bool gcm = activeProfile == SrtpProfile::AeadAes128Gcm;
+    memset(iv, 0, 16);
+    memcpy(iv, sessionSalt, gcm ? kGcmSaltLen : kCmSaltLen);
+    unsigned char* ids = gcm ? iv : iv + 2;
+    putUint48(ids, packet.ssrc);
+    putUint48(ids + 6, packet.index);
+}
+
+bool SrtpContext::protectOne(SrtpPacket& packet) {
+    unsigned char iv[16];
+    makeIv(packet, iv);
+    unsigned char* header = reinterpret_cast<unsigned char*>(packet.data);
+    unsigned char* payload = header + packet.headerLen;
+    int payloadLen = static_cast<int>(packet.length - packet.headerLen);
+    int outLen = 0;
+
+    if (EVP_CipherInit_ex2(cipher, NULL, NULL, iv, 1, NULL) != 1) {
+        return false;
+    }
+    if (activeProfile == SrtpProfile::AeadAes128Gcm) {
+        OSSL_PARAM tag[] = {
+            OSSL_PARAM_construct_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, header + packet.length, kGcmTagLen),
+            OSSL_PARAM_construct_end()
+        };
+        if (EVP_EncryptUpdate(cipher, NULL, &outLen, header, static_cast<int>(packet.headerLen)) != 1 ||
+            EVP_EncryptUpdate(cipher, payload, &outLen, payload, payloadLen) != 1 ||
+            EVP_EncryptFinal_ex(cipher, payload + outLen, &outLen) != 1 ||
+            EVP_CIPHER_CTX_get_params(cipher, tag) != 1) {
+            return false;
+        }
+        packet.length += kGcmTagLen;
+        return true;
+    }
+
+    // Encrypt, then authenticate header and ciphertext
+    unsigned char tag[EVP_MAX_MD_SIZE];
+    size_t tagLen = 0;
+    if (EVP_EncryptUpdate(cipher, payload, &outLen, payload, payloadLen) != 1 ||
+        EVP_MAC_init(mac, NULL, 0, NULL) != 1 ||
+        EVP_MAC_update(mac, header, packet.length) != 1 ||
+        EVP_MAC_final(mac, tag, &tagLen, sizeof(tag)) != 1) {
+        return false;
+    }
+    memcpy(header + packet.length, tag, kCmTagLen);
+    packet.length += kCmTagLen;
+    return true;
+}
+
+bool SrtpContext::unprotectOne(SrtpPacket& packet) {
+    size_t tagLen = overhead();
+    if (packet.length < packet.headerLen + tagLen) {
+        return false;
+    }
+    unsigned char iv[16];
+    makeIv(packet, iv);
+    unsigned char* header = reinterpret_cast<unsigned char*>(packet.data);
+    unsigned char* payload = header + packet.headerLen;
+    size_t sealedLen = packet.length - tagLen;
+    int payloadLen = static_cast<int>(sealedLen - packet.headerLen);
+    int outLen = 0;
+
+    if (activeProfile == SrtpProfile::AeadAes128Gcm) {
+        // Decrypts in place; the tag check in Final decides whether the result is kept
+        OSSL_PARAM tag[] = {
+            OSSL_PARAM_construct_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, header + sealedLen, kGcmTagLen),
+            OSSL_PARAM_construct_end()
+        };
+        if (EVP_CipherInit_ex2(cipher, NULL, NULL, iv, 0, tag) != 1 ||
+            EVP_DecryptUpdate(cipher, NULL, &outLen, header, static_cast<int>(packet.headerLen)) != 1 ||
+            EVP_DecryptUpdate(cipher, payload, &outLen, payload, payloadLen) != 1 ||
+            EVP_DecryptFinal_ex(cipher, payload + outLen, &outLen) != 1) {
+            return false;
+        }
+    } else {
+        // Authenticate before touching the payload
+        unsigned char tag[EVP_MAX_MD_SIZE];
+        size_t macLen = 0;
+        if (EVP_MAC_init(mac, NULL, 0, NULL) != 1 ||
+            EVP_MAC_update(mac, header, sealedLen) != 1 ||
+            EVP_MAC_final(mac, tag, &macLen, sizeof(tag)) != 1 ||
+            CRYPTO_memcmp(tag, header + sealedLen, kCmTagLen) != 0) {
+            return false;
+        }
+        if (EVP_CipherInit_ex2(cipher, NULL, NULL, iv, 0, NULL) != 1 ||
+            EVP_DecryptUpdate(cipher, payload, &outLen, payload, payloadLen) != 1) {
+            return false;
+        }
+    }
+    packet.length = sealedLen;
+    return true;
+}
+
+void SrtpContext::protect(SrtpPacket* packets, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < count; i++) {
+        packets[i].ok = cipher != NULL && protectOne(packets[i]);
+    }
+}
+
+size_t SrtpContext::unprotect(SrtpPacket* packets, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t passed = 0;
+    for (size_t i = 0; i < count; i++) {
+        SrtpPacket& packet = packets[i];
+        packet.ok = false;
+        if (cipher == NULL) {
+            continue;
+        }
+
+        // Cheap replay check first; windows are only created and moved by authentic packets
+        ReplayKey key = {packet.sender, packet.ssrc};
+        auto window = replay.find(key);
+        if (window != replay.end() && !window->second.check(packet.index)) {
+            replayedPackets++;
+            continue;
+        }
+        if (!unprotectOne(packet)) {
+            rejectedPackets++;
+            continue;
+        }
+        replay[key].update(packet.index);
+        packet.ok = true;
+        passed++;
+    }
+    return passed;
+}
+
+bool SrtpContext::protect(std::string& packet, size_t headerLen, const RTPHeader& header) {
+    if (header.ssrc == 0) {
+        return false;
+    }
+    size_t length = packet.size();
+    packet.resize(length + overhead());
+
+    SrtpPacket entry;
+    entry.data = &packet[0];
+    entry.headerLen = headerLen;
+    entry.length = length;
+    entry.ssrc = header.ssrc;
+    entry.index = static_cast<uint32_t>(header.sequence);
+    protect(&entry, 1);
+    packet.resize(entry.ok ? entry.length : length);
+    return entry.ok;
+}
+
+bool SrtpContext::unprotect(char* data, size_t& length, size_t headerLen, const RTPHeader& header,
+                            const struct sockaddr_in& from) {
+    if (header.ssrc == 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        rejectedPackets++;
+        return false;
+    }
+    SrtpPacket entry;
+    entry.data = data;
+    entry.headerLen = headerLen;
+    entry.length = length;
+    entry.ssrc = header.ssrc;
+    entry.index = static_cast<uint32_t>(header.sequence);
+    entry.sender = srtpSender(from);
+    unprotect(&entry, 1);
+    length = entry.length;
+    return entry.ok;
+}
+
+uint64_t newSrtpSsrc() {
+    // Random rather than derived from names: a restarted or duplicate sender
+    // would otherwise repeat (SSRC, index) pairs, and so nonces, under the same key
+    uint64_t ssrc = 0;
+    while (ssrc == 0) {
+        unsigned char bytes[6];
+        if (RAND_bytes(bytes, sizeof(bytes)) != 1) {
+            std::cerr << "No randomness for an SRTP SSRC" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < sizeof(bytes); i++) {
+            ssrc = (ssrc << 8) | bytes[i];
+        }
+    }
+    return ssrc;
+}
+
+uint64_t srtpSender(const struct sockaddr_in& addr) {
+    return (static_cast<uint64_t>(ntohl(addr.sin_addr.s_addr)) << 16) | ntohs(addr.sin_port);
+}
+
+bool parseSrtpOption(const std::string& option, SrtpProfile& profile) {
+    if (option == "srtp" || option == "srtp:gcm") {
+        profile = SrtpProfile::AeadAes128Gcm;
+        return true;
+    }
+    if (option == "srtp:cm") {
+        profile = SrtpProfile::AesCm128HmacSha1_80;
+        return true;
+    }
+    return false;
+}
+
+const char* srtpProfileName(SrtpProfile profile) {
+    return profile == SrtpProfile::AeadAes128Gcm ? "AEAD_AES_128_GCM" : "AES_CM_128_HMAC_SHA1_80";
+}
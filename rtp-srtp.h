@@ -0,0 +1,124 @@
+#ifndef RTP_SRTP_H
+#define RTP_SRTP_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <netinet/in.h>
+#include "rtp-packet.h"
+
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+typedef struct evp_mac_ctx_st EVP_MAC_CTX;
+
+// SRTP (RFC 3711 / RFC 7714) adapted to the text packet header: the header is
+// authenticated but sent in the clear, the payload is encrypted and the tag is
+// appended. Every sender picks a random SSRC (newSrtpSsrc()) and carries it in
+// the header, so restarted or duplicate senders never share a nonce; the
+// header's sequence number is the packet index.
+enum class SrtpProfile {
+    AeadAes128Gcm,      // AEAD_AES_128_GCM, 16-byte tag
+    AesCm128HmacSha1_80 // AES_CM_128_HMAC_SHA1_80, 10-byte tag, for interop
+};
+
+// One packet in a protect/unprotect batch. data holds the header followed by
+// the payload and must have room for maxOverhead() more bytes.
+struct SrtpPacket {
+    char* data;
+    size_t headerLen;  // Authenticated-only prefix
+    size_t length;     // Bytes in data, grows by the tag on protect and shrinks on unprotect
+    uint64_t ssrc;     // Random stream id from the header
+    uint64_t index;    // Header sequence number
+    uint64_t sender;   // srtpSender() of the source address, unprotect only
+    bool ok;           // Result of the last protect/unprotect
+
+    SrtpPacket() : data(NULL), headerLen(0), length(0), ssrc(0), index(0), sender(0), ok(false) {}
+};
+
+// Replay windows are kept per sender address and SSRC
+struct ReplayKey {
+    uint64_t sender;
+    uint64_t ssrc;
+
+    bool operator==(const ReplayKey& other) const { return sender == other.sender && ssrc == other.ssrc; }
+};
+
+struct ReplayKeyHash {
+    size_t operator()(const ReplayKey& key) const {
+        return std::hash<uint64_t>()(key.sender * 1099511628211ULL ^ key.ssrc);
+    }
+};
+
+// Highest index seen and a bitmap of the 64 before it, per SSRC
+struct ReplayWindow {
+    uint64_t highest;
+    uint64_t seen;
+    bool started;
+
+    ReplayWindow() : highest(0), seen(0), started(false) {}
+    bool check(uint64_t index) const; // False for duplicates and packets older than the window
+    void update(uint64_t index);      // Only after the packet authenticated
+};
+
+// One direction of an SRTP session. Session keys are derived once and the
+// cipher and MAC contexts are reused, so a batch costs one lock and no key
+// setup; per packet only the IV changes. Thread-safe.
+class SrtpContext {
+public:
+    SrtpContext();
+    ~SrtpContext();
+
+    // keyHex is the master key followed by the master salt (16 + 12 bytes for
+    // GCM, 16 + 14 for AES-CM). Any number of senders may share a key as long
+    // as each sends under its own newSrtpSsrc().
+    bool init(SrtpProfile profile, const std::string& keyHex);
+    bool is_open() const { return cipher != NULL; }
+    SrtpProfile profile() const { return activeProfile; }
+    size_t overhead() const; // Tag bytes appended to each packet
+
+    void protect(SrtpPacket* packets, size_t count);
+    size_t unprotect(SrtpPacket* packets, size_t count); // Returns how many passed; failed packets keep their length
+    long long replayed() const { return replayedPackets; }
+    long long rejected() const { return rejectedPackets; } // Failed authentication
+
+    // Single-packet helpers for the send and receive paths. packet is resized
+    // to hold the tag; data must have room for it. Headers without an SSRC fail.
+    bool protect(std::string& packet, size_t headerLen, const RTPHeader& header);
+    bool unprotect(char* data, size_t& length, size_t headerLen, const RTPHeader& header,
+                   const struct sockaddr_in& from);
+
+private:
+    SrtpContext(const SrtpContext&);
+    SrtpContext& operator=(const SrtpContext&);
+
+    bool protectOne(SrtpPacket& packet);
+    bool unprotectOne(SrtpPacket& packet);
+    void makeIv(const SrtpPacket& packet, unsigned char* iv) const;
+
+    SrtpProfile activeProfile;
+    EVP_CIPHER_CTX* cipher;
+    EVP_MAC_CTX* mac;
+    unsigned char sessionSalt[14];
+    std::unordered_map<ReplayKey, ReplayWindow, ReplayKeyHash> replay;
+    long long replayedPackets;
+    long long rejectedPackets;
+    std::mutex mutex;
+};
+
+// Most bytes any profile appends
+const size_t kSrtpMaxOverhead = 16;
+
+// Random non-zero 48-bit SSRC for a new outgoing stream
+uint64_t newSrtpSsrc();
+
+// Packs an IPv4 address and port for SrtpPacket::sender
+uint64_t srtpSender(const struct sockaddr_in& addr);
+
+// Parses "srtp" (AES-GCM) or "srtp:cm" (AES-CM/HMAC-SHA1) as used on the
+// command line; returns false if option is something else
+bool parseSrtpOption(const std::string& option, SrtpProfile& profile);
+
+const char* srtpProfileName(SrtpProfile profile);
+
+#endif // RTP_SRTP_H
@@ -0,0 +1,130 @@
+#include "rtp-timestamp.h"
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <sys/socket.h>
+#include <linux/net_tstamp.h>
+
+#ifndef SO_TIMESTAMPING
+#define SO_TIMESTAMPING 37
+#endif
+#ifndef SCM_TIMESTAMPING
+#define SCM_TIMESTAMPING SO_TIMESTAMPING
+#endif
+
+static int64_t timespecToNs(const struct timespec& ts) {
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int64_t readClockNs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return timespecToNs(ts);
+}
+
+int64_t wallClockNs() {
+    return readClockNs(CLOCK_REALTIME);
+}
+
+int64_t monotonicWallNs() {
+    // Offset is captured once so the fallback is immune to wall clock steps
+    // but still comparable with sender timestamps taken from CLOCK_REALTIME
+    static const int64_t offset = readClockNs(CLOCK_REALTIME) - readClockNs(CLOCK_MONOTONIC);
+    return readClockNs(CLOCK_MONOTONIC) + offset;
+}
+
+TimestampSource enableReceiveTimestamps(int sockfd) {
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0) {
+        return TimestampSource::Kernel;
+    }
+
+    int enable = 1;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == 0) {
+        return TimestampSource::Kernel;
+    }
+
+    perror("Receive timestamps unavailable, using monotonic clock");
+    return TimestampSource::Monotonic;
+}
+
+ssize_t recvWithTimestamp(int sockfd, char* buffer, size_t len,
+                          struct sockaddr_in* addr, socklen_t* addrLen,
+                          ReceiveTime& recvTime) {
+    struct iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len = len;
+
+    char control[256];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = addr;
+    msg.msg_namelen = addrLen ? *addrLen : 0;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t bytesReceived = recvmsg(sockfd, &msg, 0);
+    if (bytesReceived < 0) {
+        return bytesReceived;
+    }
+    if (addrLen) {
+        *addrLen = msg.msg_namelen;
+    }
+
+    bool found = false;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            // ts[0] is the software timestamp (CLOCK_REALTIME); ts[2] would be in PHC time
+            struct timespec ts[3];
+            memcpy(ts, CMSG_DATA(cmsg), sizeof(ts));
+            if (ts[0].tv_sec != 0 || ts[0].tv_nsec != 0) {
+                recvTime.ns = timespecToNs(ts[0]);
+                recvTime.source = TimestampSource::Kernel;
+                found = true;
+            }
+        } else if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            recvTime.ns = timespecToNs(ts);
+            recvTime.source = TimestampSource::Kernel;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        recvTime.ns = monotonicWallNs();
+        recvTime.source = TimestampSource::Monotonic;
+    }
+    return bytesReceived;
+}
+
+int64_t JitterEstimator::update(int64_t sendTimeNs, const ReceiveTime& recvTime) {
+    int64_t transit = recvTime.ns - sendTimeNs;
+
+    // Transit times from different clocks are not comparable, so start over
+    if (hasLast && source != recvTime.source) {
+        hasLast = false;
+        jitterNs = 0.0;
+    }
+
+    if (hasLast) {
+        double d = static_cast<double>(std::llabs(transit - lastTransitNs));
+        jitterNs += (d - jitterNs) / 16.0;
+    }
+    lastTransitNs = transit;
+    hasLast = true;
+    source = recvTime.source;
+    return transit;
+}
+
+std::string timestampSourceName(TimestampSource source) {
+    switch (source) {
+        case TimestampSource::Kernel: return "kernel";
+        default: return "monotonic";
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef RTP_TIMESTAMP_H
+#define RTP_TIMESTAMP_H
+
+#include <string>
+#include <cstdint>
+#include <arpa/inet.h>
+#include <sys/types.h>
+
+// Where a receive timestamp came from. NIC hardware timestamps are not used:
+// they are in the PHC's timescale, not CLOCK_REALTIME, so one-way delay
+// against the sender's wall clock would be meaningless.
+enum class TimestampSource {
+    Kernel,    // Kernel software timestamp via SO_TIMESTAMPING / SO_TIMESTAMPNS
+    Monotonic  // User-space CLOCK_MONOTONIC fallback, mapped onto the wall clock epoch
+};
+
+struct ReceiveTime {
+    int64_t ns;             // Nanoseconds since the Unix epoch
+    TimestampSource source;
+
+    ReceiveTime() : ns(0), source(TimestampSource::Monotonic) {}
+};
+
+// RFC 3550 interarrival jitter estimator (section 6.4.1), kept in nanoseconds
+struct JitterEstimator {
+    double jitterNs;
+    int64_t lastTransitNs;
+    bool hasLast;
+    TimestampSource source;
+
+    JitterEstimator() : jitterNs(0.0), lastTransitNs(0), hasLast(false), source(TimestampSource::Monotonic) {}
+
+    // Feeds one packet; returns its one-way delay in nanoseconds
+    int64_t update(int64_t sendTimeNs, const ReceiveTime& recvTime);
+    double jitterMs() const { return jitterNs / 1e6; }
+};
+
+// Asks the kernel to attach receive timestamps to every datagram on sockfd.
+// Returns the best source that could be enabled.
+TimestampSource enableReceiveTimestamps(int sockfd);
+
+// recvfrom() replacement that also extracts the receive timestamp from the
+// ancillary data, falling back to the monotonic clock when there is none.
+ssize_t recvWithTimestamp(int sockfd, char* buffer, size_t len,
+                          struct sockaddr_in* addr, socklen_t* addrLen,
+                          ReceiveTime& recvTime);
+
+int64_t wallClockNs();       // CLOCK_REALTIME, used to stamp outgoing packets
+int64_t monotonicWallNs();   // CLOCK_MONOTONIC shifted onto the CLOCK_REALTIME epoch
+
+std::string timestampSourceName(TimestampSource source);
+
+#endif // RTP_TIMESTAMP_H
@@ -0,0 +1,147 @@
+#include "rtp-trace.h"
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char kTraceMagic[8] = {'R', 'T', 'P', 'T', 'R', 'C', '2', '\0'};
+
+static_assert(sizeof(TraceFileHeader) == 64, "trace header must stay 64 bytes");
+static_assert(sizeof(TraceRecord) == 128, "trace records must stay 128 bytes");
+
+TraceWriter::TraceWriter() : fd(-1), mapping(NULL), mappedBytes(0) {}
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const std::string& filename) {
+    close();
+    fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("Trace open failed");
+        return false;
+    }
+    if (!grow()) {
+        close();
+        return false;
+    }
+
+    TraceFileHeader* header = reinterpret_cast<TraceFileHeader*>(mapping);
+    memcpy(header->magic, kTraceMagic, sizeof(kTraceMagic));
+    header->recordCount = 0;
+    return true;
+}
+
+bool TraceWriter::grow() {
+    size_t newSize = mappedBytes + kTraceGrowBytes;
+    if (ftruncate(fd, newSize) < 0) {
+        perror("Trace grow failed");
+        return false;
+    }
+
+    void* grown;
+    if (mapping == NULL) {
+        grown = mmap(NULL, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    } else {
+        grown = mremap(mapping, mappedBytes, newSize, MREMAP_MAYMOVE);
+    }
+    if (grown == MAP_FAILED) {
+        perror("Trace mmap failed");
+        return false;
+    }
+    mapping = static_cast<char*>(grown);
+    mappedBytes = newSize;
+    return true;
+}
+
+void TraceWriter::append(const TraceRecord& record) {
+    if (mapping == NULL) {
+        return;
+    }
+    TraceFileHeader* header = reinterpret_cast<TraceFileHeader*>(mapping);
+    size_t offset = sizeof(TraceFileHeader) + header->recordCount * sizeof(TraceRecord);
+    if (offset + sizeof(TraceRecord) > mappedBytes) {
+        if (!grow()) {
+            return;
+        }
+        header = reinterpret_cast<TraceFileHeader*>(mapping);
+    }
+
+    // Publish the count only after the record itself is in place
+    memcpy(mapping + offset, &record, sizeof(TraceRecord));
+    __atomic_store_n(&header->recordCount, header->recordCount + 1, __ATOMIC_RELEASE);
+}
+
+uint64_t TraceWriter::recordCount() const {
+    if (mapping == NULL) {
+        return 0;
+    }
+    return reinterpret_cast<const TraceFileHeader*>(mapping)->recordCount;
+}
+
+void TraceWriter::close() {
+    if (mapping != NULL) {
+        size_t used = sizeof(TraceFileHeader) + recordCount() * sizeof(TraceRecord);
+        munmap(mapping, mappedBytes);
+        if (ftruncate(fd, used) < 0) {
+            perror("Trace trim failed");
+        }
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    fd = -1;
+    mapping = NULL;
+    mappedBytes = 0;
+}
+
+TraceReader::TraceReader() : mapping(NULL), mappedBytes(0), records(NULL), count(0) {}
+
+TraceReader::~TraceReader() {
+    close();
+}
+
+bool TraceReader::open(const std::string& filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(TraceFileHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    mapping = static_cast<const char*>(mapped);
+    mappedBytes = st.st_size;
+
+    const TraceFileHeader* header = reinterpret_cast<const TraceFileHeader*>(mapping);
+    if (memcmp(header->magic, kTraceMagic, sizeof(kTraceMagic)) != 0) {
+        close();
+        return false;
+    }
+
+    // A trace from a server that was killed is still padded to the grow size
+    uint64_t available = (mappedBytes - sizeof(TraceFileHeader)) / sizeof(TraceRecord);
+    count = header->recordCount < available ? header->recordCount : available;
+    records = reinterpret_cast<const TraceRecord*>(mapping + sizeof(TraceFileHeader));
+    return true;
+}
+
+void TraceReader::close() {
+    if (mapping != NULL) {
+        munmap(const_cast<char*>(mapping), mappedBytes);
+    }
+    mapping = NULL;
+    mappedBytes = 0;
+    records = NULL;
+    count = 0;
+}
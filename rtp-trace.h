@@ -0,0 +1,75 @@
+#ifndef RTP_TRACE_H
+#define RTP_TRACE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Packet trace ("RTPTRC2"): a 64-byte file header followed by fixed 128-byte
+// records, one per received datagram, each with the first bytes of its payload
+// so control messages such as SUBSCRIBE replay intact. The writer appends
+// through a shared mapping that grows in kTraceGrowBytes steps, so capturing a
+// packet costs one 128-byte copy; recordCount in the header always covers only
+// complete records.
+
+struct TraceFileHeader {
+    char magic[8];         // "RTPTRC2\0"
+    uint64_t recordCount;
+    char reserved[48];
+};
+
+struct TraceRecord {
+    int64_t arrivalNs;     // Receive timestamp (see rtp-timestamp.h)
+    int64_t sendTimeNs;    // Sender timestamp from the packet header, 0 if none
+    uint32_t srcAddr;      // Source IPv4 address, network byte order
+    uint16_t srcPort;      // Source port, network byte order
+    uint16_t size;         // Datagram size in bytes, header included
+    int32_t sequence;      // Sequence number from the packet header
+    uint32_t flags;        // kTraceHasHeader when the packet had an RTP header
+    char source[32];       // Source id from the packet header, NUL padded
+    uint16_t payloadLen;   // Payload size in the original datagram
+    uint16_t capturedLen;  // Bytes of it kept below, at most kTracePayloadBytes
+    char payload[60];      // Start of the payload (the whole datagram if it had no header)
+};
+
+static const size_t kTracePayloadBytes = sizeof(TraceRecord::payload);
+static const uint32_t kTraceHasHeader = 1;
+static const size_t kTraceGrowBytes = 64 * 1024 * 1024;
+
+class TraceWriter {
+public:
+    TraceWriter();
+    ~TraceWriter();
+
+    bool open(const std::string& filename);
+    bool is_open() const { return fd >= 0; }
+    void append(const TraceRecord& record);
+    void close(); // Trims the file to the records actually written
+    uint64_t recordCount() const;
+
+private:
+    int fd;
+    char* mapping;
+    size_t mappedBytes;
+
+    bool grow();
+};
+
+class TraceReader {
+public:
+    TraceReader();
+    ~TraceReader();
+
+    bool open(const std::string& filename);
+    void close();
+    uint64_t size() const { return count; }
+    const TraceRecord& operator[](uint64_t index) const { return records[index]; }
+
+private:
+    const char* mapping;
+    size_t mappedBytes;
+    const TraceRecord* records;
+    uint64_t count;
+};
+
+#endif // RTP_TRACE_H